@@ -24,6 +24,7 @@
 #include "helperFunctions.h"
 
 #include <map>
+#include <set>
 #include <utility>
 #include <vector>
 
@@ -72,6 +73,20 @@ private:
     DefaultValuesList m_replaceList;
     DefaultValuesList m_replaceListASM;
     bool m_useNASM{true};
+    uint m_unitySize{0};
+    vector<string> m_unityExcludes;
+    bool m_usePCH{false};
+    bool m_usePGO{false};
+    bool m_useNinja{false};
+    bool m_useProps{false};
+    bool m_useARM64{false};
+    bool m_splitComponents{false};
+    set<string> m_componentConfigs;
+    string m_fileSettings;
+    uint m_shardCount{0};
+    vector<string> m_configurations;
+    vector<string> m_isaVariants;
+    vector<string> m_platforms;
     ConfigList m_cachedConfigLists;
 
 public:
@@ -92,8 +107,11 @@ public:
      */
     bool outputConfig();
 
-    /** Deletes any files that may have been previously created by outputConfig. */
-    void deleteCreatedFiles() const;
+    /**
+     * Deletes any files that may have been previously created by outputConfig.
+     * @param staleOnly (Optional) True to only delete files that have not been output during this run.
+     */
+    void deleteCreatedFiles(bool staleOnly = false) const;
 
 private:
     /**
@@ -53,13 +53,23 @@ bool loadFromResourceFile(int resourceID, string& retString);
 
 /**
  * Writes to file.
+ * @remark The file is only written if its contents differ from those of any existing file so that unchanged files keep
+ *  their timestamps.
  * @param fileName Filename of the file.
  * @param inString The inString to write.
  * @param binary   (Optional) True to write in binary mode (in normal text mode line ending are converted to OS
  *                  specific).
+ * @param track    (Optional) True to record the file as an output of the current run (see isFileWritten).
  * @return True if it succeeds, false if it fails.
  */
-bool writeToFile(const string& fileName, const string& inString, bool binary = false);
+bool writeToFile(const string& fileName, const string& inString, bool binary = false, bool track = true);
+
+/**
+ * Query if a file has been output by writeToFile (whether or not it needed to be changed).
+ * @param fileName Filename of the file.
+ * @return True if the file has been output, false if not.
+ */
+bool isFileWritten(const string& fileName);
 
 /**
  * Copies an internal embedded resource to a file.
@@ -167,6 +177,38 @@ void findAndReplace(string& inString, const string& search, const string& replac
  */
 bool findEnvironmentVariable(const string& envVar);
 
+/**
+ * Runs an external command and waits for it to complete.
+ * @remark The command is run through the system shell so it may be a script or contain redirection.
+ * @param       command     The command line to run.
+ * @param       input       The data to pass to the commands standard input.
+ * @param [out] output      The returned standard output of the command.
+ * @param [out] errors      The returned standard error of the command.
+ * @param       environment (Optional) The list of environment variables (NAME=value) to run the command with. If empty
+ *  then the current environment is used.
+ * @return True if it succeeds, false if the command could not be run or returned an error.
+ */
+bool runProcess(const string& command, const string& input, string& output, string& errors,
+    const vector<string>& environment = vector<string>());
+
+struct ProcessJob
+{
+    string command;
+    string input;
+    string output;
+    string errors;
+    bool success = false;
+};
+
+/**
+ * Runs a list of external commands in parallel across all available processor cores.
+ * @param [in,out] jobs        The list of jobs to run. On return each contains the output and result of its command.
+ * @param          environment (Optional) The list of environment variables (NAME=value) to run each command with. If
+ *  empty then the current environment is used.
+ * @return True if all jobs succeed, false if any fail.
+ */
+bool runProcesses(vector<ProcessJob>& jobs, const vector<string>& environment = vector<string>());
+
 /** Press key to continue terminal prompt. */
 void pressKeyToContinue();
 
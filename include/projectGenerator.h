@@ -25,29 +25,73 @@
 
 #include <fstream>
 #include <set>
+#include <unordered_set>
 
 class ProjectGenerator
 {
 private:
     using StaticList = vector<string>;
     using UnknownList = map<string, StaticList>;
+    using TemplateSlots = map<string, StaticList>;
+
+    struct TemplateSegment
+    {
+        string text;        ///< Literal template text output before the slot.
+        string slot;        ///< Name of the slot following the text (empty for the last segment).
+        string slotDefault; ///< Original template text output if the slot is given no value.
+    };
+
+    struct NinjaBuild
+    {
+        string build;                 ///< Build statements for all projects output so far.
+        map<string, StaticList> libs; ///< External libraries required by each project.
+        StaticList staticTargets;     ///< Static libraries and programs.
+        StaticList sharedTargets;     ///< Shared libraries.
+    };
+
+    struct FileSetting
+    {
+        string pattern;            ///< Wildcard pattern matched against the root relative source file name.
+        StaticList configurations; ///< Wildcard patterns of the configurations the flags apply to (empty for all).
+        string flags;              ///< The additional compiler flags.
+    };
+
+    struct ComponentUsage
+    {
+        bool uses{false};    ///< True if the file directly uses any component options.
+        StaticList includes; ///< Files included by the file (relative to the project).
+    };
+
     ifstream m_inputFile;
     string m_inLine;
     StaticList m_includes;
     StaticList m_includesCPP;
     StaticList m_includesC;
     StaticList m_includesASM;
+    StaticList m_includesGAS;
     StaticList m_includesH;
     StaticList m_includesCU;
     UnknownList m_replaceIncludes;
+    map<string, string> m_sourceFileSettings;
     StaticList m_libs;
     UnknownList m_unknowns;
     string m_projectName;
     string m_projectDir;
 
     map<string, StaticList> m_projectLibs;
+    map<string, StaticList> m_projectShards;
+    map<string, string> m_resolvedDCEDefines;
+    map<string, string> m_resolvedDCETags;
+    StaticList m_msvcEnvironment;
+    map<int, vector<TemplateSegment>> m_templates;
+    map<string, string> m_propsFiles;
+    map<string, ComponentUsage> m_componentFiles;
+    NinjaBuild m_ninjaBuild;
+    vector<FileSetting> m_fileSettings;
 
     const string m_tempDirectory = "FFVSTemp/";
+    const string m_cacheDirectory = "FFVSCache/";
+    set<string> m_cacheKeys;
 
 public:
     ConfigGenerator m_configHelper;
@@ -59,8 +103,17 @@ public:
      */
     bool passAllMake();
 
-    /** Deletes any files that may have been created by previous runs. */
-    void deleteCreatedFiles();
+    /**
+     * Deletes any files that may have been created by previous runs.
+     * @param staleOnly (Optional) True to only delete files that have not been output during this run.
+     */
+    void deleteCreatedFiles(bool staleOnly = false);
+
+    /**
+     * Deletes any pre-processed results stored in the cache.
+     * @param unusedOnly True to only delete results that have not been used or stored during this run.
+     */
+    void deletePreProcessorCache(bool unusedOnly);
 
     /**
      * Error function to cleanly exit.
@@ -83,6 +136,46 @@ private:
      */
     bool outputProgramProject(const string& destinationFile, const string& destinationFilterFile);
 
+    /**
+     * Splits the sources of the current library between several shard projects that can be built in parallel.
+     * @remark Each shard is a static library that is combined into the current project. The sources are balanced
+     *  between shards by file size while generated files, C++ files and headers are kept in the current project.
+     * @param includeDirs The list of additional include directories.
+     * @param defines     The list of additional defines.
+     * @return True if it succeeds, false if it fails.
+     */
+    bool outputProjectShards(const StaticList& includeDirs, const StaticList& defines);
+
+    /**
+     * Gets the name of the library that the current project belongs to.
+     * @remark For a shard project this is the library that the shard is combined into.
+     * @return The library name.
+     */
+    string getLibraryName() const;
+
+    /**
+     * Adds the build statements for the current project to the ninja build file.
+     * @remark Objects are given the same names as in the project file. Programs are only linked against the static
+     *  libraries while each library is output as both a static and a shared library.
+     * @param includeDirs The list of additional include directories.
+     * @param defines     The list of additional defines.
+     * @param program     True if the current project is a program.
+     * @return True if it succeeds, false if it fails.
+     */
+    bool outputNinjaProject(const StaticList& includeDirs, const StaticList& defines, bool program);
+
+    /**
+     * Outputs a ninja build file containing the build statements of every previously output project.
+     * @return True if it succeeds, false if it fails.
+     */
+    bool outputNinjaBuild();
+
+    /**
+     * Converts a directory used in a project file into the equivalent for use in a ninja build file.
+     * @param [in,out] path The directory to convert.
+     */
+    static void buildNinjaPath(string& path);
+
     /** Cleans up any used variables after a project file has been created. */
     void outputProjectCleanup();
 
@@ -142,6 +235,20 @@ private:
      */
     bool passDMMXInclude();
 
+    /**
+     * Pass a static aarch64 include line (e.g. NEON-OBJS) from current makefile.
+     * @param length The length of the object list identifier.
+     * @return True if it succeeds, false if it fails.
+     */
+    bool passARMInclude(uint length);
+
+    /**
+     * Pass a dynamic aarch64 include line (e.g. NEON-OBJS-$(CONFIG_...)) from current makefile.
+     * @param length The length of the object list identifier.
+     * @return True if it succeeds, false if it fails.
+     */
+    bool passDARMInclude(uint length);
+
     /**
      * Pass a static header include line from current makefile.
      * @return True if it succeeds, false if it fails.
@@ -240,6 +347,53 @@ private:
         }
     };
 
+    struct DCECondition
+    {
+        enum Type
+        {
+            Value,
+            Tag,
+            Not,
+            And,
+            Or,
+            Equal,
+            NotEqual
+        };
+
+        Type type = Value;
+        string tag;
+        vector<DCECondition> operands;
+    };
+
+    struct ExportMatcher
+    {
+        struct Node
+        {
+            map<char, uint> children;
+            bool wildcard = false;
+        };
+
+        vector<Node> nodes;
+        unordered_set<string> exact;
+    };
+
+    struct SymbolRecord
+    {
+        string name;
+        bool data;
+        bool definition;
+    };
+
+    struct UnitySymbols
+    {
+        set<string> objects;     ///< Object names of the contained files.
+        set<string> declared;    ///< Names of any file scope static variables, functions, types and enumerators.
+        set<string> macros;      ///< Macros left defined at the end of the file.
+        set<string> identifiers; ///< All identifiers used.
+        StaticList includes;     ///< Files included outside of any conditional block.
+        bool standalone = false; ///< Contains macros that change the behaviour of later includes.
+    };
+
     /**
      * Builds project specific DCE functions and variables that are not automatically detected.
      * @param [out] definitionsDCE The return list of built DCE functions.
@@ -251,94 +405,477 @@ private:
 
     bool createReplaceFiles(const StaticList& replaceIncludes, StaticList& existingIncludes);
 
+    /**
+     * Creates unity build files that each combine several of the current projects C source files.
+     * @remark Files are only combined with others in the same directory and only when they don't have conflicting
+     *  static symbols or macros. Any file that cannot be combined is left as is.
+     * @param [out] unityFiles    The created unity build files.
+     * @param [out] unityIncludes The source files that have been combined into a unity build file.
+     * @return True if it succeeds, false if it fails.
+     */
+    bool createUnityFiles(StaticList& unityFiles, StaticList& unityIncludes);
+
+    /**
+     * Creates a precompiled header from the stable headers most commonly included by the current projects C source
+     * files.
+     * @remark The header is forced included into every compatible source file and is created by compiling a generated
+     *  stub file which is added to the projects C source files. Files that define macros before their includes are
+     *  left out as are any C++ and generated wrapper files. Headers that use component options are never precompiled.
+     * @param [in,out] slots The template slots to add the precompiled header settings to.
+     * @return True if it succeeds, false if it fails.
+     */
+    bool createPrecompiledHeader(TemplateSlots& slots);
+
+    /**
+     * Loads the per file compiler flag rules from the file passed using the file-settings option.
+     * @remark Each line contains a wildcard file pattern relative to the source root, an optional comma separated
+     *  list of configuration patterns ending in ':' and then the flags to add to every matching file.
+     * @return True if it succeeds, false if it fails.
+     */
+    bool loadFileSettings();
+
+    /**
+     * Gets the additional per file project settings for a source file from the loaded file rules.
+     * @remark Switches with ClCompile item metadata (e.g. /O2, /Ob2, /GL) are set through it so that they replace the
+     *  project defaults, any others are added to AdditionalOptions.
+     * @param fileName Filename of the source file (relative to the project).
+     * @return The project item settings, empty if no rules match.
+     */
+    string getFileSettingsMSVC(const string& fileName) const;
+
+    /**
+     * Gets the additional ninja compiler flags for a source file from the loaded file rules.
+     * @param fileName Filename of the source file (relative to the project).
+     * @return The compiler flags, empty if no rules match.
+     */
+    string getFileSettingsNinja(const string& fileName) const;
+
+    /**
+     * Finds all the files that are included by an assembly source file.
+     * @remark Any nested includes are also found so that the returned list can be used to track when the source file
+     *  needs to be rebuilt.
+     * @param          fileName    Filename of the assembly file (relative to the project).
+     * @param [in,out] retIncludes The returned list of included files (relative to the project).
+     * @return True if it succeeds, false if it fails.
+     */
+    bool findASMIncludes(const string& fileName, StaticList& retIncludes) const;
+
+    /**
+     * Checks if a source file uses any of the component options found in config_components.h.
+     * @remark Any files included by the source file are also checked. The contents of each file are only scanned once
+     *  so that shared headers are not loaded again for every file that includes them.
+     * @param       fileName  Filename of the source file (relative to the project).
+     * @param [out] retUsage  True if the file uses any component options.
+     * @return True if it succeeds, false if it fails.
+     */
+    bool findComponentUsage(const string& fileName, bool& retUsage);
+
+    /**
+     * Finds the symbols in a source file that may conflict with other files in the same unity build file.
+     * @param       code    The source code with comments removed.
+     * @param [out] symbols The found symbols.
+     */
+    static void findUnitySymbols(const string& code, UnitySymbols& symbols);
+
+    /**
+     * Finds the names declared by a file scope static or typedef declaration.
+     * @param          statement The tokens of the declaration.
+     * @param [in,out] symbols   The found symbols.
+     */
+    static void findUnitySymbolsDeclarator(const StaticList& statement, UnitySymbols& symbols);
+
+    /**
+     * Removes any comments and the contents of any strings from source code.
+     * @remark New lines are kept so that pre-processor directives can still be found and any continued lines are
+     *  joined. The file names of any include directives are kept so that included templates and source files can
+     *  still be detected.
+     * @param       file    The source code.
+     * @param [out] retCode The source code without comments.
+     */
+    static void removeComments(const string& file, string& retCode);
+
     bool findProjectFiles(const StaticList& includes, StaticList& includesC, StaticList& includesCPP,
-        StaticList& includesASM, StaticList& includesH, StaticList& includesCU) const;
+        StaticList& includesASM, StaticList& includesGAS, StaticList& includesH, StaticList& includesCU) const;
+
+    /**
+     * Gets the architecture that a source file is specific to.
+     * @param fileName Filename of the source file.
+     * @return The architecture directory name (x86 or aarch64), empty if the file is not architecture specific.
+     */
+    static string getSourceArch(const string& fileName);
+
+    /**
+     * Loads a template resource and compiles it into a list of literal text segments separated by named slots.
+     * @remark Each template is only compiled once and is then reused for every output file. Any WinRT sections are
+     *  removed during compilation if WinRT is not enabled.
+     * @param resourceID The template resource ID.
+     * @return True if it succeeds, false if it fails.
+     */
+    bool buildTemplate(int resourceID);
 
-    void outputTemplateTags(string& projectTemplate, string& filtersTemplate) const;
+    /**
+     * Adds a slot to a template for each occurrence of a search string.
+     * @param          templateFile The template text.
+     * @param          search       The string to search for.
+     * @param          slot         The name of the slot.
+     * @param          replace      True to have the slot replace the search string, false to add it after.
+     * @param [in,out] positions    The slots found so far ordered by template position.
+     */
+    static void buildTemplateSlots(const string& templateFile, const string& search, const string& slot, bool replace,
+        multimap<uint, pair<string, uint>>& positions);
+
+    /**
+     * Adds a slot to a project template for each of the additional dependencies of every configuration.
+     * @remark The slot used by each occurrence is based on the configuration of the section that contains it.
+     * @param          templateFile The template text.
+     * @param [in,out] positions    The slots found so far ordered by template position.
+     * @return True if it succeeds, false if it fails.
+     */
+    static bool buildTemplateDependencySlots(const string& templateFile, multimap<uint, pair<string, uint>>& positions);
+
+    /**
+     * Gets the configuration of the template section that contains a position.
+     * @param templateFile The template text.
+     * @param position     The position within the template.
+     * @return The configuration and platform (e.g. Debug|x64), empty if the position is not in a configuration section.
+     */
+    static string getTemplateConfiguration(const string& templateFile, uint position);
+
+    /**
+     * Query if a configuration should be output.
+     * @remark Programs also keep any configuration that a requested solution configuration is mapped to.
+     * @param configuration The configuration and platform (e.g. Debug|x64).
+     * @param program       True if the configuration is for a program.
+     * @return True if the configuration is enabled, false if not.
+     */
+    bool isConfigurationEnabled(const string& configuration, bool program) const;
+
+    /**
+     * Renders a compiled template in a single pass.
+     * @remark Each occurrence of a slot outputs the next of the slots values (wrapping around to the first).
+     * @param       resourceID The template resource ID.
+     * @param       slots      The values for each slot.
+     * @param [out] retOutput  The rendered output.
+     * @return True if it succeeds, false if it fails.
+     */
+    bool outputTemplate(int resourceID, const TemplateSlots& slots, string& retOutput);
+
+    /**
+     * Output the values of the template tags.
+     * @param [in,out] slots The template slots.
+     */
+    void outputTemplateTags(TemplateSlots& slots) const;
+
+    /**
+     * Gets the project configurations that are output using the current options.
+     * @remark WinRT configurations are only included when WinRT is enabled. The shared configurations include any
+     *  profile guided optimisation and instruction set variant configurations as they are copies of ReleaseDLL.
+     * @param       staticConfigs True to get the static library configurations.
+     * @param       sharedConfigs True to get the dll configurations.
+     * @param [out] retConfigs    The returned list of configurations.
+     */
+    void getBuildConfigurations(bool staticConfigs, bool sharedConfigs, StaticList& retConfigs) const;
 
     void outputSourceFileType(StaticList& fileList, const string& type, const string& filterType,
-        string& projectTemplate, string& filterTemplate, StaticList& foundObjects, set<string>& foundFilters,
-        bool checkExisting, bool staticOnly = false, bool sharedOnly = false) const;
+        string& projectSources, string& filterSources, StaticList& foundObjects, set<string>& foundFilters,
+        bool checkExisting, bool staticOnly = false, bool sharedOnly = false, bool excluded = false) const;
+
+    /**
+     * Gets the name of the object file output when compiling a source file.
+     * @remark Several source files have the same name so any that clash with a previously found object are instead
+     *  named using their path relative to the source directory.
+     * @param          fileName      The project relative source file name.
+     * @param          checkExisting True to check for clashes with previously found objects.
+     * @param [in,out] foundObjects  The list of objects found so far.
+     * @param [out]    retObjectName The object name without extension.
+     * @return True if the object name was changed to prevent a clash.
+     */
+    bool getSourceObjectName(
+        const string& fileName, bool checkExisting, StaticList& foundObjects, string& retObjectName) const;
 
-    void outputSourceFiles(string& projectTemplate, string& filterTemplate);
+    bool outputSourceFiles(TemplateSlots& slots);
 
     bool outputProjectExports(const StaticList& includeDirs);
 
     /**
-     * Executes a batch script to perform operations using a compiler based on current configuration.
+     * Builds a matcher used to quickly check names against a list of export strings.
+     * @param       exportStrings The list of export strings (may contain trailing wildcards).
+     * @param [out] matcher       The returned export matcher.
+     */
+    static void outputProjectExportsBuildMatcher(const StaticList& exportStrings, ExportMatcher& matcher);
+
+    /**
+     * Checks if a name matches any of the export strings used to build an export matcher.
+     * @param matcher The export matcher.
+     * @param name    The name to check.
+     * @return True if the name is exported, false if not.
+     */
+    static bool outputProjectExportsMatch(const ExportMatcher& matcher, const string& name);
+
+    /**
+     * Decodes each of the function and data records found in a loaded compiler generated sbr file.
+     * @param          fileSBR The loaded sbr file.
+     * @param [in,out] records The list of decoded records to add to.
+     */
+    static void outputProjectExportsDecodeSBR(const string& fileSBR, vector<SymbolRecord>& records);
+
+    /**
+     * Decodes each of the global function and data symbols defined in a loaded ELF or COFF object file.
+     * @param          fileObject The loaded object file.
+     * @param [in,out] records    The list of decoded records to add to.
+     */
+    static void outputProjectExportsDecodeObject(const string& fileObject, vector<SymbolRecord>& records);
+
+    /**
+     * Finds any exported functions and data by directly searching the definitions in the current projects source files.
+     * @param          matcher           The export matcher built from the projects export strings.
+     * @param [in,out] moduleExports     The list of found exported functions.
+     * @param [in,out] moduleDataExports The list of found exported data.
+     * @param [in,out] unresolvedFiles   The list of files whose exports could not be determined without a compiler.
+     * @return True if it succeeds, false if it fails.
+     */
+    bool outputProjectExportsStatic(const ExportMatcher& matcher, set<string>& moduleExports,
+        set<string>& moduleDataExports, StaticList& unresolvedFiles);
+
+    /**
+     * Searches a loaded source file for definitions of exported functions and data.
+     * @remark Pre-processor conditionals are resolved using the current configuration.
+     * @param          file              The loaded file to search through.
+     * @param          matcher           The export matcher built from the projects export strings.
+     * @param [in,out] moduleExports     The list of found exported functions.
+     * @param [in,out] moduleDataExports The list of found exported data.
+     * @return True if it succeeds, false if the exports depend on values that can only be determined by a compiler.
+     */
+    bool outputProjectExportsFindDefinitions(const string& file, const ExportMatcher& matcher,
+        set<string>& moduleExports, set<string>& moduleDataExports);
+
+    /**
+     * Runs a compiler to generate symbol information for input files based on current configuration.
      * @param          includeDirs      The list of current directories to look for included files.
      * @param [in,out] directoryObjects A list of subdirectories with each one containing a vector of files contained
      *   within it.
-     * @param          runType          The type of operation to run on input files (0=generate an sbr file, 1=pre-
-     *  process to .i file).
      * @returns True if it succeeds, false if it fails.
      */
-    bool runCompiler(
-        const vector<string>& includeDirs, map<string, vector<string>>& directoryObjects, int runType) const;
+    bool runCompiler(const vector<string>& includeDirs, map<string, vector<string>>& directoryObjects);
+
+    /**
+     * Finds and sets up the msvc build environment.
+     * @remark The environment is only searched for once and is then reused for all subsequent compiler calls.
+     * @returns True if it succeeds, false if it fails.
+     */
+    bool findMSVCEnvironment();
 
     /**
-     * Executes a batch script to perform operations using the msvc compiler.
+     * Runs the msvc compiler in parallel on each input file.
      * @param          includeDirs      The list of current directories to look for included files.
      * @param [in,out] directoryObjects A list of subdirectories with each one containing a vector of files contained
      *   within it.
-     * @param          runType          The type of operation to run on input files (0=generate an sbr file, 1=pre-
-     *  process to .i file).
      * @returns True if it succeeds, false if it fails.
      */
-    bool runMSVC(const vector<string>& includeDirs, map<string, vector<string>>& directoryObjects, int runType) const;
+    bool runMSVC(const vector<string>& includeDirs, map<string, vector<string>>& directoryObjects);
 
     /**
-     * Executes a bash script to perform operations using the gcc compiler.
+     * Runs the gcc compiler in parallel on each input file.
      * @param          includeDirs      The list of current directories to look for included files.
      * @param [in,out] directoryObjects A list of subdirectories with each one containing a vector of files contained
      *   within it.
-     * @param          runType          The type of operation to run on input files (1=pre-process to .i file).
      * @returns True if it succeeds, false if it fails.
      */
-    bool runGCC(const vector<string>& includeDirs, map<string, vector<string>>& directoryObjects, int runType) const;
+    bool runGCC(const vector<string>& includeDirs, map<string, vector<string>>& directoryObjects);
+
+    /**
+     * Pre-processes a list of source files using a compiler based on current configuration.
+     * @remark Results are cached so that unchanged files are not passed to the compiler again.
+     * @param          includeDirs The list of current directories to look for included files.
+     * @param [in,out] sourceFiles A list of source file names each containing the source text to pre-process. On
+     *  return each text is replaced with the pre-processed output.
+     * @returns True if it succeeds, false if it fails.
+     */
+    bool runPreProcessor(const vector<string>& includeDirs, map<string, string>& sourceFiles);
+
+    /**
+     * Pre-processes a list of source files using the msvc compiler.
+     * @param          responseFile The compiler response file containing the include directories and defines.
+     * @param [in,out] sourceFiles  A list of source file names each containing the source text to pre-process. On
+     *  return each text is replaced with the pre-processed output.
+     * @returns True if it succeeds, false if it fails.
+     */
+    bool runPreProcessorMSVC(const string& responseFile, map<string, string>& sourceFiles);
+
+    /**
+     * Pre-processes a list of source files using the gcc compiler.
+     * @param          responseFile The compiler response file containing the include directories and defines.
+     * @param [in,out] sourceFiles  A list of source file names each containing the source text to pre-process. On
+     *  return each text is replaced with the pre-processed output.
+     * @returns True if it succeeds, false if it fails.
+     */
+    bool runPreProcessorGCC(const string& responseFile, map<string, string>& sourceFiles);
+
+    /**
+     * Builds the complete list of include directories to pass to a compiler.
+     * @param       includeDirs    The list of current directories to look for included files.
+     * @param [out] retIncludeDirs The returned list of include directories.
+     */
+    void buildCompilerIncludeDirs(const vector<string>& includeDirs, vector<string>& retIncludeDirs) const;
+
+    /**
+     * Builds a compiler response file containing the include directories and defines shared by all compiler calls.
+     * @param       includeDirs     The list of current directories to look for included files.
+     * @param [out] retResponseFile The returned response file text.
+     */
+    void buildCompilerResponseFile(const vector<string>& includeDirs, string& retResponseFile) const;
+
+    /**
+     * Gets the number of files that should be passed to each compiler call.
+     * @param numFiles The total number of files to compile.
+     * @returns The number of files in each batch.
+     */
+    static uint getCompilerBatchSize(uint numFiles);
+
+    /**
+     * Gets the msvc compatible compiler executable to use for the current toolchain.
+     * @remark The msvc compiler is always used when generating browse information as no other compiler supports it.
+     * @param runType The type of compiler call (0=generate symbol information, 1=pre-process).
+     * @returns The compiler executable.
+     */
+    string getCompiler(int runType) const;
+
+    /**
+     * Writes the input files needed to pre-process a list of source files in batches.
+     * @remark Each source is written to its own small wrapper file. Files from the same source directory are then
+     *  grouped into batches sized to the number of available cores, each listed in its own response file.
+     * @param       sourceFiles A list of source file names each containing the source text to pre-process.
+     * @param       folder      The folder to write the input files to.
+     * @param [out] retBatches  The returned list of batches each containing the original source directory and the
+     *  source files in the batch.
+     * @param [out] retWrappers The returned wrapper file name for each source file.
+     * @returns True if it succeeds, false if it fails.
+     */
+    static bool outputPreProcessorBatches(const map<string, string>& sourceFiles, const string& folder,
+        vector<pair<string, StaticList>>& retBatches, map<string, string>& retWrappers);
+
+    /**
+     * Splits the output of a batched pre-processor call back into the individual source files.
+     * @param          output      The pre-processor output.
+     * @param          batchFiles  The source files in the batch in the order they were passed to the compiler.
+     * @param          wrappers    The wrapper file name for each source file.
+     * @param [in,out] sourceFiles A list of source file names. On return the text of each file in the batch is replaced
+     *  with its pre-processed output.
+     * @returns True if it succeeds, false if it fails.
+     */
+    static bool splitPreProcessorOutput(const string& output, const StaticList& batchFiles,
+        const map<string, string>& wrappers, map<string, string>& sourceFiles);
+
+    /**
+     * Removes any line markers from pre-processed output and gets the list of included files that they reference.
+     * @param          fileName    The name of the pre-processed source file.
+     * @param [in,out] output      The pre-processed output.
+     * @param [in,out] retIncludes The list of included files.
+     */
+    void removePreProcessorLineMarkers(const string& fileName, string& output, set<string>& retIncludes) const;
+
+    /**
+     * Gets a hash of some data.
+     * @param data The data to hash.
+     * @returns The hash as a hexadecimal string.
+     */
+    static string getHash(const string& data);
+
+    /**
+     * Gets a hash of the contents of a file.
+     * @param          fileName   Filename of the file.
+     * @param [in,out] fileHashes The list of previously found file hashes.
+     * @param [out]    retHash    The returned hash.
+     * @returns True if it succeeds, false if the file could not be loaded.
+     */
+    static bool getFileHash(const string& fileName, map<string, string>& fileHashes, string& retHash);
+
+    /**
+     * Searches the cache for a previously pre-processed result.
+     * @remark The result is only used if none of the files included by the original source have since changed.
+     * @param          key        The cache key built from the source file and compiler flags.
+     * @param [in,out] fileHashes The list of previously found file hashes.
+     * @param [out]    retOutput  The returned pre-processed output.
+     * @returns True if a valid result was found, false if not.
+     */
+    bool findPreProcessorCache(const string& key, map<string, string>& fileHashes, string& retOutput);
+
+    /**
+     * Stores a pre-processed result in the cache.
+     * @remark The cache is stored in the solution directory and is not recorded as a generated output.
+     * @param          key        The cache key built from the source file and compiler flags.
+     * @param          includes   The list of files included by the source file.
+     * @param [in,out] fileHashes The list of previously found file hashes.
+     * @param          output     The pre-processed output.
+     */
+    void outputPreProcessorCache(
+        const string& key, const set<string>& includes, map<string, string>& fileHashes, const string& output);
+
+    /** Outputs any errors found in the log file of a failed msvc compilation. */
+    static void outputMSVCErrors();
 
     /**
      * Output additional build events to the project.
-     * @param [in,out] projectTemplate The project template.
+     * @param [in,out] slots The template slots.
      */
-    void outputBuildEvents(string& projectTemplate);
+    void outputBuildEvents(TemplateSlots& slots);
 
     /**
      * Output additional include search directories to project.
-     * @param          includeDirs     The include dirs.
-     * @param [in,out] projectTemplate The project template.
+     * @param          includeDirs The include dirs.
+     * @param [in,out] slots       The template slots.
      */
-    static void outputIncludeDirs(const StaticList& includeDirs, string& projectTemplate);
+    static void outputIncludeDirs(const StaticList& includeDirs, TemplateSlots& slots);
 
     /**
      * Output additional library search directories to project.
-     * @param          lib32Dirs       The library 32b dirs.
-     * @param          lib64Dirs       The library 64b dirs.
-     * @param [in,out] projectTemplate The project template.
+     * @param          lib32Dirs The library 32b dirs.
+     * @param          lib64Dirs The library 64b dirs.
+     * @param [in,out] slots     The template slots.
      */
-    static void outputLibDirs(const StaticList& lib32Dirs, const StaticList& lib64Dirs, string& projectTemplate);
+    static void outputLibDirs(const StaticList& lib32Dirs, const StaticList& lib64Dirs, TemplateSlots& slots);
 
     /**
      * Output additional defines to the project.
-     * @param          defines         The defines.
-     * @param [in,out] projectTemplate The project template.
+     * @param          defines The defines.
+     * @param [in,out] slots   The template slots.
      */
-    static void outputDefines(const StaticList& defines, string& projectTemplate);
+    static void outputDefines(const StaticList& defines, TemplateSlots& slots);
 
     /**
      * Output asm tools to project template.
      * @remark Either yasm or nasm tools will be used based on current configuration.
-     * @param [in,out] projectTemplate The project template.
+     * @param [in,out] slots The template slots.
      */
-    void outputASMTools(string& projectTemplate) const;
+    void outputASMTools(TemplateSlots& slots) const;
+
+    /**
+     * Gets the custom build step settings used to assemble each asm file.
+     * @remark The build step allows files to be assembled in parallel. The included files found when generating the
+     *  project must be added separately as additional inputs, any others are only found through the file tracker of
+     *  the build step. When using nasm a dependency file is also output for each object.
+     * @param rootDir     The project relative root directory.
+     * @param libraryName The name of the library whose x86 source directory is searched for included files.
+     * @return The custom build settings.
+     */
+    string getASMBuild(const string& rootDir, const string& libraryName) const;
 
     /**
      * Output cuda tools to project template.
-     * @param [in,out] projectTemplate The project template.
+     * @param [in,out] slots The template slots.
      */
-    void outputCUDATools(string& projectTemplate) const;
+    void outputCUDATools(TemplateSlots& slots) const;
 
-    bool outputDependencyLibs(string& projectTemplate, bool program = false);
+    void outputDependencyLibs(TemplateSlots& slots);
+
+    /**
+     * Output references to the library projects that the current project depends on.
+     * @remark The references are only used by configurations that build a dll as static libraries can be built
+     *  independently of each other.
+     * @param [in,out] slots The template slots.
+     * @return True if it succeeds, false if it fails.
+     */
+    bool outputProjectReferences(TemplateSlots& slots) const;
 
     /**
      * Removes any WinRT/UWP configurations from the output project template.
@@ -352,6 +889,89 @@ private:
      */
     static void outputStripWinRTSolution(string& solutionFile);
 
+    /**
+     * Removes any configurations that have not been requested from the output project template.
+     * @param [in,out] projectTemplate The project template.
+     * @param          program         True if the template is for a program.
+     */
+    void outputStripConfigurations(string& projectTemplate, bool program) const;
+
+    /**
+     * Removes any configurations that have not been requested from the output solution template.
+     * @param [in,out] solutionFile The solution template.
+     */
+    void outputStripConfigurationsSolution(string& solutionFile) const;
+
+    /**
+     * Moves the common settings of every configuration from the output project template into a props file.
+     * @remark Settings that are changed for each project (e.g. defines, include directories and dependencies) are
+     *  left in the project along with any that use template tags. The project then imports the props file.
+     * @param [in,out] projectTemplate The project template.
+     * @param          propsName       The file name of the props file.
+     * @param [out]    retProps        The props file.
+     */
+    static void outputSplitProps(string& projectTemplate, const string& propsName, string& retProps);
+
+    /**
+     * Adds profile guided optimisation configurations to the output project template.
+     * @remark The ReleasePGInstrument and ReleasePGOptimize configurations are copies of the ReleaseDLL configurations
+     *  that use whole program optimisation with a profile database shared between them. Binaries and libraries are
+     *  output to a pgo sub-directory so that the default ReleaseDLL build is not overwritten.
+     * @param [in,out] projectTemplate The project template.
+     */
+    static void outputAddPGO(string& projectTemplate);
+
+    /**
+     * Finds each configuration section in a project template that matches a search string.
+     * @param       projectTemplate The project template.
+     * @param       search          The configuration (and optionally platform) to search for (e.g. "ReleaseDLL|").
+     * @param [out] retSections     The found sections mapped to the position after their last consecutive sibling.
+     */
+    static void findTemplateSections(
+        const string& projectTemplate, const string& search, map<uint, StaticList>& retSections);
+
+    /**
+     * Adds profile guided optimisation configurations to the output solution template.
+     * @param [in,out] solutionFile The solution template.
+     */
+    static void outputAddPGOSolution(string& solutionFile);
+
+    /**
+     * Adds instruction set variant configurations to the output project template.
+     * @remark Each requested variant (e.g. ReleaseAVX2) is a copy of the ReleaseDLL x64 configuration that enables the
+     *  matching enhanced instruction set. Binaries and libraries are output to a variant sub-directory so that they
+     *  can be shipped alongside the default build.
+     * @param [in,out] projectTemplate The project template.
+     */
+    void outputAddISA(string& projectTemplate) const;
+
+    /**
+     * Adds instruction set variant configurations to the output solution template.
+     * @param [in,out] solutionFile The solution template.
+     */
+    void outputAddISASolution(string& solutionFile) const;
+
+    /**
+     * Adds ARM64 configurations to the output project template.
+     * @remark Each x64 section is copied to an equivalent ARM64 section that outputs to ARM64 sub-directories.
+     * @param [in,out] projectTemplate The project template.
+     */
+    static void outputAddARM64(string& projectTemplate);
+
+    /**
+     * Adds ARM64 configurations to the output solution template.
+     * @param [in,out] solutionFile The solution template.
+     */
+    static void outputAddARM64Solution(string& solutionFile);
+
+    /**
+     * Converts an output project file into a shard project.
+     * @remark All configurations are converted to static libraries that are output to the intermediate directory.
+     *  Configurations that previously built a dll keep defining _WINDLL so that they match the parent project.
+     * @param [in,out] projectFile The project file.
+     */
+    static void outputConvertShard(string& projectFile);
+
     /**
      * Search through files in the current project and finds any undefined elements that are used in DCE blocks. A new
      * file is then created and added to the project that contains hull definitions for any missing functions.
@@ -377,6 +997,38 @@ private:
      */
     void outputProgramDCEsResolveDefine(string& define);
 
+    /**
+     * Parses a pre-processor define conditional string into a condition tree.
+     * @remark Any defined(X) or function-like macro is kept as a single opaque tag along with its parameters.
+     * @param          define    The pre-processor define string.
+     * @param [in,out] pos       The current parse position within the define string.
+     * @param          level     The operator precedence level to parse (0=||, 1=&&, 2===/!=, 3=unary).
+     * @param [out]    condition The returned condition tree.
+     * @return True if it succeeds, false if it fails.
+     */
+    static bool outputProgramDCEsParseDefine(const string& define, uint& pos, uint level, DCECondition& condition);
+
+    /**
+     * Replaces any known tags in a condition tree with their current configuration settings.
+     * @remark Unknown and reserved tags are left in place so they can be resolved later by the pre-processor.
+     * @param [in,out] condition The condition tree to update.
+     */
+    void outputProgramDCEsReplaceTags(DCECondition& condition);
+
+    /**
+     * Simplifies a condition tree by folding constants and converting it to a canonical form (sorted operands with
+     * duplicates removed).
+     * @param [in,out] condition The condition tree to simplify.
+     */
+    static void outputProgramDCEsSimplifyDefine(DCECondition& condition);
+
+    /**
+     * Converts a condition tree back into a pre-processor define conditional string.
+     * @param condition The condition tree.
+     * @return The pre-processor define string.
+     */
+    static string outputProgramDCEsPrintDefine(const DCECondition& condition);
+
     /**
      * Find any declaration of a specified function. Can also find a definition of the function if no declaration as
      * found first.
@@ -399,11 +1051,14 @@ private:
 
     /**
      * Combines 2 pre-processor define conditional strings.
-     * @param       define    The first define.
-     * @param       define2   The second define.
-     * @param [out] retDefine The returned combined define.
+     * @param       define     The first define.
+     * @param       define2    The second define.
+     * @param [out] retDefine  The returned combined define.
+     * @param       combineAll (Optional) True to require both defines (&&) instead of either (||). An empty define
+     *                         has no condition so then neither does the result.
      */
-    static void outputProgramDCEsCombineDefine(const string& define, const string& define2, string& retDefine);
+    static void outputProgramDCEsCombineDefine(
+        const string& define, const string& define2, string& retDefine, bool combineAll = false);
 };
 
 #endif
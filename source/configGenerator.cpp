@@ -357,6 +357,28 @@ bool ConfigGenerator::changeConfig(const string& option)
         outputLine("  --dce-only               do not output a project and only generate missing DCE files");
         outputLine(
             "  --use-yasm               use YASM instead of the default NASM (this is not advised as it does not support newer instructions)");
+        outputLine(
+            "  --unity-size=N           combine up to N C source files of each directory into unity build files [0]");
+        outputLine(
+            "  --unity-exclude=LIST     comma separated list of C source files to keep out of unity build files");
+        outputLine("  --use-pch                use a generated precompiled header in each library project");
+        outputLine(
+            "  --use-pgo                add profile guided optimisation configurations and a training script to the solution");
+        outputLine(
+            "  --use-ninja              also output a build.ninja file for gcc compatible compilers (e.g. mingw-w64 or clang)");
+        outputLine("  --use-arm64              add ARM64 configurations that use the aarch64 NEON assembly");
+        outputLine("  --use-props              share the common settings of all projects through generated props files");
+        outputLine(
+            "  --split-components       output the component options to config_components.h so that only files using them are rebuilt");
+        outputLine(
+            "  --file-settings=FILE     add extra compiler flags to matching source files using the rules found in FILE");
+        outputLine(
+            "  --isa-variants=LIST      comma separated list of additional x64 instruction set configurations (AVX2, AVX512)");
+        outputLine(
+            "  --shard-count=N          split the sources of large libraries into up to N separately built static library projects [0]");
+        outputLine(
+            "  --configurations=LIST    comma separated list of configurations to output (e.g. Debug,ReleaseDLL) [all]");
+        outputLine("  --platforms=LIST         comma separated list of platforms to output (Win32, x64, ARM64) [all]");
         // Add in reserved values
         vector<string> reservedItems;
         buildReservedValues(reservedItems);
@@ -380,11 +402,13 @@ bool ConfigGenerator::changeConfig(const string& option)
             // changing on the fly afterwards
         } else if (toolChain == "icl") {
             // Inline asm by default is turned on if icl is detected
+        } else if (toolChain == "clang-cl") {
+            // Inline asm by default is turned on if clang is detected
         } else {
 #ifdef _MSC_VER
             // Only support msvc when built with msvc
             outputError("Unknown toolchain option (" + toolChain + ")");
-            outputError("Excepted toolchains (msvc, icl)", false);
+            outputError("Excepted toolchains (msvc, icl, clang-cl)", false);
             return false;
 #else
             // Only support other toolchains if DCE only
@@ -470,6 +494,130 @@ bool ConfigGenerator::changeConfig(const string& option)
     } else if (option == "--use-yasm") {
         // This has no parameters and just sets internal value
         m_useNASM = false;
+    } else if (option == "--use-pgo") {
+        // This has no parameters and just sets internal value
+        m_usePGO = true;
+    } else if (option == "--use-arm64") {
+        // This has no parameters and just sets internal value
+        m_useARM64 = true;
+    } else if (option == "--split-components") {
+        // This has no parameters and just sets internal value
+        m_splitComponents = true;
+    } else if (option == "--use-props") {
+        // This has no parameters and just sets internal value
+        m_useProps = true;
+    } else if (option == "--use-ninja") {
+        // This has no parameters and just sets internal value
+        m_useNinja = true;
+    } else if (option == "--use-pch") {
+        // This has no parameters and just sets internal value
+        m_usePCH = true;
+    } else if (option.find("--unity-size") == 0) {
+        // Check for correct command syntax
+        const string value = (option.length() > 13) ? option.substr(13) : "";
+        if ((option.at(12) != '=') || value.empty() || (value.find_first_not_of("0123456789") != string::npos)) {
+            outputError("Incorrect unity-size syntax (" + option + ")");
+            outputError("Excepted syntax (--unity-size=N)", false);
+            return false;
+        }
+        m_unitySize = stoul(value);
+    } else if (option.find("--shard-count") == 0) {
+        // Check for correct command syntax
+        const string value = (option.length() > 14) ? option.substr(14) : "";
+        if ((option.at(13) != '=') || value.empty() || (value.find_first_not_of("0123456789") != string::npos)) {
+            outputError("Incorrect shard-count syntax (" + option + ")");
+            outputError("Excepted syntax (--shard-count=N)", false);
+            return false;
+        }
+        m_shardCount = stoul(value);
+    } else if (option.find("--file-settings") == 0) {
+        // Check for correct command syntax
+        if ((option.length() <= 16) || (option.at(15) != '=')) {
+            outputError("Incorrect file-settings syntax (" + option + ")");
+            outputError("Excepted syntax (--file-settings=FILE)", false);
+            return false;
+        }
+        m_fileSettings = option.substr(16);
+        replace(m_fileSettings.begin(), m_fileSettings.end(), '\\', '/');
+    } else if (option.find("--unity-exclude") == 0) {
+        // Check for correct command syntax
+        if (option.at(15) != '=') {
+            outputError("Incorrect unity-exclude syntax (" + option + ")");
+            outputError("Excepted syntax (--unity-exclude=LIST)", false);
+            return false;
+        }
+        // Add each file in the list
+        string value = option.substr(16);
+        replace(value.begin(), value.end(), '\\', '/');
+        uint startPos = 0;
+        while (startPos < value.length()) {
+            uint endPos = value.find(',', startPos);
+            endPos = (endPos == string::npos) ? value.length() : endPos;
+            if (endPos > startPos) {
+                m_unityExcludes.push_back(value.substr(startPos, endPos - startPos));
+            }
+            startPos = endPos + 1;
+        }
+    } else if ((option.find("--configurations") == 0) || (option.find("--platforms") == 0)) {
+        // Check for correct command syntax
+        const bool platforms = (option.find("--platforms") == 0);
+        const string name = platforms ? "platforms" : "configurations";
+        if ((option.length() <= name.length() + 2) || (option.at(name.length() + 2) != '=')) {
+            outputError("Incorrect " + name + " syntax (" + option + ")");
+            outputError("Excepted syntax (--" + name + "=LIST)", false);
+            return false;
+        }
+        vector<string> validValues = {"Win32", "x64", "ARM64"};
+        if (!platforms) {
+            validValues = {"Debug", "DebugDLL", "DebugDLLWinRT", "DebugWinRT", "Release", "ReleaseDLL",
+                "ReleaseDLLStaticDeps", "ReleaseDLLWinRT", "ReleaseDLLWinRTStaticDeps", "ReleaseWinRT",
+                "ReleasePGInstrument", "ReleasePGOptimize", "ReleaseAVX2", "ReleaseAVX512"};
+        }
+        vector<string>& values = platforms ? m_platforms : m_configurations;
+        // Add each value in the list
+        const string value = option.substr(name.length() + 3);
+        uint startPos = 0;
+        while (startPos < value.length()) {
+            uint endPos = value.find(',', startPos);
+            endPos = (endPos == string::npos) ? value.length() : endPos;
+            if (endPos > startPos) {
+                string item = value.substr(startPos, endPos - startPos);
+                // The solution refers to Win32 as x86 so allow either to be used
+                item = (item == "x86") ? "Win32" : item;
+                if (find(validValues.begin(), validValues.end(), item) == validValues.end()) {
+                    outputError("Unknown " + name + " value (" + item + ")");
+                    return false;
+                }
+                values.push_back(item);
+            }
+            startPos = endPos + 1;
+        }
+    } else if (option.find("--isa-variants") == 0) {
+        // Check for correct command syntax
+        if ((option.length() <= 15) || (option.at(14) != '=')) {
+            outputError("Incorrect isa-variants syntax (" + option + ")");
+            outputError("Excepted syntax (--isa-variants=LIST)", false);
+            return false;
+        }
+        string value = option.substr(15);
+        transform(value.begin(), value.end(), value.begin(), ::toupper);
+        // Add each instruction set in the list
+        uint startPos = 0;
+        while (startPos < value.length()) {
+            uint endPos = value.find(',', startPos);
+            endPos = (endPos == string::npos) ? value.length() : endPos;
+            if (endPos > startPos) {
+                const string item = value.substr(startPos, endPos - startPos);
+                if ((item != "AVX2") && (item != "AVX512")) {
+                    outputError("Unknown isa-variants value (" + item + ")");
+                    return false;
+                }
+                if (find(m_isaVariants.begin(), m_isaVariants.end(), item) == m_isaVariants.end()) {
+                    m_isaVariants.push_back(item);
+                }
+            }
+            startPos = endPos + 1;
+        }
     } else if (option.find("--use-existing-config") == 0) {
         // A input config file has been specified
         m_usingExistingConfig = true;
@@ -859,6 +1007,24 @@ bool ConfigGenerator::outputConfig()
         }
     }
 
+    // Get the list of component options (these are always split when the source already uses a separate file)
+    m_componentConfigs.clear();
+    if (m_splitComponents || (m_configureFile.find("config_components.h") != string::npos)) {
+        vector<string> list;
+        if (!getConfigList("ALL_COMPONENTS", list)) {
+            return false;
+        }
+        for (const auto& i : list) {
+            const auto option2 = getConfigOption(i);
+            if (option2 != m_configValues.end()) {
+                m_componentConfigs.insert(option2->m_prefix + option2->m_option);
+            }
+        }
+    }
+    string configureComponentsFile = fileHeader;
+    configureComponentsFile += "\n#ifndef SMP_CONFIG_COMPONENTS_H\n";
+    configureComponentsFile += "#define SMP_CONFIG_COMPONENTS_H\n";
+
     // Create ASM config file
     string header2 = fileHeader;
     header2.replace(header2.find(" */", header2.length() - 4), 3, ";******");
@@ -869,6 +1035,7 @@ bool ConfigGenerator::outputConfig()
         findPos += 3;
     }
     string configureFileASM = header2 + '\n';
+    string configureComponentsFileASM = configureFileASM;
 
     // Output all internal options
     for (const auto& i : m_configValues) {
@@ -880,11 +1047,15 @@ bool ConfigGenerator::outputConfig()
         } else {
             addConfig = "#define " + sTagName + ' ' + i.m_value;
         }
-        configureFile += addConfig + '\n';
+        // Component options are output to their own files
+        const bool component = (m_componentConfigs.find(sTagName) != m_componentConfigs.end());
+        string& addFile = component ? configureComponentsFile : configureFile;
+        addFile += addConfig + '\n';
+        string& addFileASM = component ? configureComponentsFileASM : configureFileASM;
         if ((i.m_value != "0") && (m_replaceListASM.find(sTagName) != m_replaceListASM.end())) {
-            configureFileASM += m_replaceListASM[sTagName] + '\n';
+            addFileASM += m_replaceListASM[sTagName] + '\n';
         } else {
-            configureFileASM += "%define " + sTagName + ' ' + i.m_value + '\n';
+            addFileASM += "%define " + sTagName + ' ' + i.m_value + '\n';
         }
     }
 
@@ -901,6 +1072,20 @@ bool ConfigGenerator::outputConfig()
         outputError("Failed opening output asm configure file (" + configFile + ")");
         return false;
     }
+    if (!m_componentConfigs.empty()) {
+        outputLine("  Outputting config_components.h...");
+        configureComponentsFile += "#endif /* SMP_CONFIG_COMPONENTS_H */\n";
+        configFile = m_solutionDirectory + "config_components.h";
+        if (!writeToFile(configFile, configureComponentsFile)) {
+            outputError("Failed opening output components configure file (" + configFile + ")");
+            return false;
+        }
+        configFile = m_solutionDirectory + "config_components.asm";
+        if (!writeToFile(configFile, configureComponentsFileASM)) {
+            outputError("Failed opening output asm components configure file (" + configFile + ")");
+            return false;
+        }
+    }
 
     // Output avconfig.h
     outputLine("  Outputting avconfig.h...");
@@ -986,17 +1171,21 @@ bool ConfigGenerator::outputConfig()
     return true;
 }
 
-void ConfigGenerator::deleteCreatedFiles() const
+void ConfigGenerator::deleteCreatedFiles(const bool staleOnly) const
 {
     if (!m_usingExistingConfig) {
         // Delete any previously generated files
         vector<string> existingFiles;
         findFiles(m_solutionDirectory + "config.h", existingFiles, false);
         findFiles(m_solutionDirectory + "config.asm", existingFiles, false);
+        findFiles(m_solutionDirectory + "config_components.h", existingFiles, false);
+        findFiles(m_solutionDirectory + "config_components.asm", existingFiles, false);
         findFiles(m_solutionDirectory + "libavutil/avconfig.h", existingFiles, false);
         findFiles(m_solutionDirectory + "libavutil/ffversion.h", existingFiles, false);
         for (const auto& i : existingFiles) {
-            deleteFile(i);
+            if (!staleOnly || !isFileWritten(i)) {
+                deleteFile(i);
+            }
         }
     }
 }
@@ -140,6 +140,18 @@ bool ConfigGenerator::buildDefaultValues()
         }
     }
 
+    // Enable aarch64 hardware architecture and extensions
+    if (m_useARM64) {
+        fastToggleConfigValue("aarch64", true);
+        const string armExtensions[] = {"armv8", "neon", "vfp"};
+        for (const auto& i : armExtensions) {
+            fastToggleConfigValue(i, true);
+            fastToggleConfigValue(i + "_external", true);
+            fastToggleConfigValue(i + "_inline", true);
+        }
+        fastToggleConfigValue("intrinsics_neon", true);
+    }
+
     // Default we enable asm
     fastToggleConfigValue("yasm", true);
     fastToggleConfigValue("x86asm", true);
@@ -423,7 +435,7 @@ bool ConfigGenerator::buildDefaultValues()
 
 bool ConfigGenerator::buildForcedValues()
 {
-    // Additional options set for Intel compiler specific inline asm
+    // Additional options set for Intel/clang compiler specific inline asm
     fastToggleConfigValue("inline_asm_nonlocal_labels", false);
     fastToggleConfigValue("inline_asm_direct_symbol_refs", false);
     fastToggleConfigValue("inline_asm_non_intel_mnemonic", false);
@@ -469,6 +481,8 @@ void ConfigGenerator::buildReplaceValues(
     // Add to config.h only list
     replaceValues["CC_IDENT"] = "#if defined(__INTEL_COMPILER)\n\
 #   define CC_IDENT \"icl\"\n\
+#elif defined(__clang__)\n\
+#   define CC_IDENT \"clang-cl\"\n\
 #else\n\
 #   define CC_IDENT \"msvc\"\n\
 #endif";
@@ -518,12 +532,12 @@ void ConfigGenerator::buildReplaceValues(
 #else\n\
 #   define HAVE_FAST_64BIT 0\n\
 #endif";
-    replaceValues["HAVE_INLINE_ASM"] = "#if defined(__INTEL_COMPILER)\n\
+    replaceValues["HAVE_INLINE_ASM"] = "#if defined(__INTEL_COMPILER) || defined(__clang__)\n\
 #   define HAVE_INLINE_ASM 1\n\
 #else\n\
 #   define HAVE_INLINE_ASM 0\n\
 #endif";
-    replaceValues["HAVE_MM_EMPTY"] = "#if defined(__INTEL_COMPILER) || ARCH_X86_32\n\
+    replaceValues["HAVE_MM_EMPTY"] = "#if defined(__INTEL_COMPILER) || defined(__clang__) || ARCH_X86_32\n\
 #   define HAVE_MM_EMPTY 1\n\
 #else\n\
 #   define HAVE_MM_EMPTY 0\n\
@@ -766,6 +780,43 @@ void ConfigGenerator::buildReplaceValues(
         replaceValues[name] = "#define " + name + " ARCH_X86 && HAVE_INLINE_ASM";
     }
 
+    // ARM64 builds use the same config file but none of the x86 specific options
+    if (m_useARM64) {
+        const string arm64Define = "defined(__aarch64__) || defined(_M_ARM64)";
+        replaceValues["ARCH_X86"] = "#if " + arm64Define + "\n\
+#   define ARCH_X86 0\n\
+#else\n\
+#   define ARCH_X86 1\n\
+#endif";
+        replaceValues["ARCH_AARCH64"] = "#if " + arm64Define + "\n\
+#   define ARCH_AARCH64 1\n\
+#else\n\
+#   define ARCH_AARCH64 0\n\
+#endif";
+        replaceValues["ARCH_X86_32"] = "#if !defined(__x86_64) && !defined(_M_X64) && !(" + arm64Define + ")\n\
+#   define ARCH_X86_32 1\n\
+#else\n\
+#   define ARCH_X86_32 0\n\
+#endif";
+        // ARM64 is also a 64bit platform
+        const string values64[] = {"EXTERN_PREFIX", "EXTERN_ASM", "HAVE_ALIGNED_STACK", "HAVE_FAST_64BIT"};
+        for (const auto& i : values64) {
+            findAndReplace(replaceValues[i], "defined(_M_X64)", "defined(_M_X64) || " + arm64Define);
+        }
+        const string armExtensions[] = {"ARMV8", "NEON", "VFP"};
+        for (const auto& i : armExtensions) {
+            string name = "HAVE_" + i;
+            replaceValues[name] = "#define " + name + " ARCH_AARCH64";
+            name = "HAVE_" + i + "_EXTERNAL";
+            replaceValues[name] = "#define " + name + " ARCH_AARCH64";
+            name = "HAVE_" + i + "_INLINE";
+            replaceValues[name] = "#define " + name + " ARCH_AARCH64 && HAVE_INLINE_ASM";
+        }
+        replaceValues["HAVE_INTRINSICS_NEON"] = "#define HAVE_INTRINSICS_NEON ARCH_AARCH64";
+        // The asm config file is only used by x86 assembly
+        replaceValuesASM["ARCH_AARCH64"] = "%define ARCH_AARCH64 0";
+    }
+
     // Sanity checks for inline asm (Needed as some code only checks availability and not inline_asm)
     replaceValues["HAVE_EBP_AVAILABLE"] = "#if HAVE_INLINE_ASM && !defined(_DEBUG)\n\
 #   define HAVE_EBP_AVAILABLE 1\n\
@@ -1199,7 +1250,7 @@ void ConfigGenerator::buildObjects(const string& tag, vector<string>& objects)
         objects.emplace_back("getopt");
     } else if (tag == "EMMS_OBJS__yes_") {
         if (isConfigOptionEnabled("MMX_EXTERNAL")) {
-            objects.emplace_back("x86/emms"); // asm emms is not required in 32b but is for 64bit unless with icl
+            objects.emplace_back("x86/emms"); // asm emms is not required in 32b but is for 64bit unless with icl/clang
         }
     }
 }
@@ -21,16 +21,26 @@
 #include "helperFunctions.h"
 
 #include <algorithm>
+#include <atomic>
 #include <direct.h>
 #include <fstream>
 #include <iostream>
+#include <mutex>
+#include <set>
+#include <thread>
 
 #ifdef _WIN32
 #    include "Shlwapi.h"
 
 #    include <Windows.h>
 #else
+#    include <csignal>
 #    include <dirent.h>
+#    include <fcntl.h>
+#    include <pthread.h>
+#    include <spawn.h>
+#    include <sys/wait.h>
+#    include <unistd.h>
 extern char _binary_compat_h_start[];
 extern char _binary_compat_h_end[];
 extern char _binary_math_h_start[];
@@ -119,8 +129,59 @@ bool loadFromResourceFile(const int resourceID, string& retString)
 #endif
 }
 
-bool writeToFile(const string& fileName, const string& inString, const bool binary)
+static set<string> g_writtenFiles;
+
+static string getWrittenFileKey(const string& fileName)
+{
+    // Normalise the path so that it matches those returned by findFiles
+    string key = fileName;
+    replace(key.begin(), key.end(), '\\', '/');
+    uint pos = 0;
+    while ((pos = key.find("//", pos)) != string::npos) {
+        key.erase(pos, 1);
+    }
+#ifdef _WIN32
+    transform(key.begin(), key.end(), key.begin(), tolower);
+#endif
+    return key;
+}
+
+static bool isFileContentEqual(const string& fileName, const string& inString, const bool binary)
 {
+    ifstream inputFile(fileName, (binary) ? ios_base::in | ios_base::binary : ios_base::in);
+    if (!inputFile.is_open()) {
+        return false;
+    }
+    if (binary) {
+        // Binary files can be checked by size before reading anything
+        inputFile.seekg(0, std::ifstream::end);
+        if (static_cast<uint>(inputFile.tellg()) != inString.length()) {
+            return false;
+        }
+        inputFile.seekg(0, std::ifstream::beg);
+    }
+    // Compare the file contents one block at a time
+    char buffer[65536];
+    uint pos = 0;
+    while (inputFile.read(buffer, sizeof(buffer)) || (inputFile.gcount() > 0)) {
+        const uint read = static_cast<uint>(inputFile.gcount());
+        if ((pos + read > inString.length()) || (inString.compare(pos, read, buffer, read) != 0)) {
+            return false;
+        }
+        pos += read;
+    }
+    return pos == inString.length();
+}
+
+bool writeToFile(const string& fileName, const string& inString, const bool binary, const bool track)
+{
+    if (track) {
+        g_writtenFiles.insert(getWrittenFileKey(fileName));
+    }
+    // Skip writing if the file is unchanged
+    if (isFileContentEqual(fileName, inString, binary)) {
+        return true;
+    }
     // Check for subdirectories
     const uint dirPos = fileName.rfind('/');
     if (dirPos != string::npos) {
@@ -143,46 +204,18 @@ bool writeToFile(const string& fileName, const string& inString, const bool bina
     return true;
 }
 
-bool copyResourceFile(const int resourceID, const string& destinationFile, const bool binary)
+bool isFileWritten(const string& fileName)
 {
-#ifdef _WIN32
-    // Can load directly from windows resource file
-    HINSTANCE hInst = GetModuleHandle(nullptr);
-    HRSRC hRes = FindResource(hInst, MAKEINTRESOURCE(resourceID), RT_RCDATA);
-    HGLOBAL hMem = LoadResource(hInst, hRes);
-    DWORD size = SizeofResource(hInst, hRes);
-    char* resText = static_cast<char*>(LockResource(hMem));
-
-    // Copy across the file
-    ofstream dest(destinationFile, (binary) ? ios_base::out | ios_base::binary : ios_base::out);
-    if (!dest.is_open()) {
-        FreeResource(hMem);
-        return false;
-    }
-    if (!dest.write(resText, size)) {
-        dest.close();
-        FreeResource(hMem);
-        return false;
-    }
-    dest.close();
+    return g_writtenFiles.find(getWrittenFileKey(fileName)) != g_writtenFiles.end();
+}
 
-    // Close Resource
-    FreeResource(hMem);
-    return true;
-#else
-    uint size = (uint)(&pp_cEndArray[resourceID - 100] - &pp_cStartArray[resourceID - 100]);
-    // Copy across the file
-    ofstream dest(destinationFile, (binary) ? ios_base::out | ios_base::binary : ios_base::out);
-    if (!dest.is_open()) {
-        return false;
-    }
-    if (!dest.write(pp_cStartArray[resourceID - 100], size)) {
-        dest.close();
+bool copyResourceFile(const int resourceID, const string& destinationFile, const bool binary)
+{
+    string resource;
+    if (!loadFromResourceFile(resourceID, resource)) {
         return false;
     }
-    dest.close();
-    return false;
-#endif
+    return writeToFile(destinationFile, resource, binary);
 }
 
 void deleteFile(const string& destinationFile)
@@ -567,6 +600,219 @@ bool findEnvironmentVariable(const string& envVar)
 #endif
 }
 
+// Serialises process creation so that pipes are only ever inherited by the process they were created for
+static mutex g_processMutex;
+
+bool runProcess(
+    const string& command, const string& input, string& output, string& errors, const vector<string>& environment)
+{
+    output.clear();
+    errors.clear();
+#ifdef _WIN32
+    // Create pipes for each of the standard streams
+    HANDLE inRead, inWrite, outRead, outWrite, errRead, errWrite;
+    if (!CreatePipe(&inRead, &inWrite, nullptr, 0)) {
+        return false;
+    }
+    if (!CreatePipe(&outRead, &outWrite, nullptr, 0)) {
+        CloseHandle(inRead);
+        CloseHandle(inWrite);
+        return false;
+    }
+    if (!CreatePipe(&errRead, &errWrite, nullptr, 0)) {
+        CloseHandle(inRead);
+        CloseHandle(inWrite);
+        CloseHandle(outRead);
+        CloseHandle(outWrite);
+        return false;
+    }
+
+    // Build the environment block if one was specified
+    string environmentBlock;
+    for (const auto& i : environment) {
+        environmentBlock += i + '\0';
+    }
+    environmentBlock += '\0';
+
+    STARTUPINFOA startupInfo = {};
+    startupInfo.cb = sizeof(STARTUPINFOA);
+    startupInfo.dwFlags = STARTF_USESTDHANDLES;
+    startupInfo.hStdInput = inRead;
+    startupInfo.hStdOutput = outWrite;
+    startupInfo.hStdError = errWrite;
+    PROCESS_INFORMATION processInfo = {};
+    string commandLine = "cmd.exe /c " + command;
+    BOOL created;
+    {
+        // Only the child ends of the pipes should be inherited
+        lock_guard<mutex> lock(g_processMutex);
+        SetHandleInformation(inRead, HANDLE_FLAG_INHERIT, HANDLE_FLAG_INHERIT);
+        SetHandleInformation(outWrite, HANDLE_FLAG_INHERIT, HANDLE_FLAG_INHERIT);
+        SetHandleInformation(errWrite, HANDLE_FLAG_INHERIT, HANDLE_FLAG_INHERIT);
+        created = CreateProcessA(nullptr, &commandLine[0], nullptr, nullptr, TRUE, CREATE_NO_WINDOW,
+            environment.empty() ? nullptr : &environmentBlock[0], nullptr, &startupInfo, &processInfo);
+        CloseHandle(inRead);
+        CloseHandle(outWrite);
+        CloseHandle(errWrite);
+    }
+    if (!created) {
+        CloseHandle(inWrite);
+        CloseHandle(outRead);
+        CloseHandle(errRead);
+        return false;
+    }
+
+    // Input and errors are handled on separate threads so that a full pipe can not block the child process
+    const auto readPipe = [](HANDLE pipe, string& retString) {
+        char buffer[65536];
+        DWORD read;
+        while (ReadFile(pipe, buffer, sizeof(buffer), &read, nullptr) && (read > 0)) {
+            retString.append(buffer, read);
+        }
+    };
+    thread inputThread([&]() {
+        uint pos = 0;
+        DWORD written;
+        while ((pos < input.length()) &&
+            WriteFile(inWrite, input.data() + pos, static_cast<DWORD>(min<uint>(input.length() - pos, 65536)),
+                &written, nullptr)) {
+            pos += written;
+        }
+        CloseHandle(inWrite);
+    });
+    thread errorThread([&]() { readPipe(errRead, errors); });
+    readPipe(outRead, output);
+    inputThread.join();
+    errorThread.join();
+    CloseHandle(outRead);
+    CloseHandle(errRead);
+
+    WaitForSingleObject(processInfo.hProcess, INFINITE);
+    DWORD exitCode = 1;
+    GetExitCodeProcess(processInfo.hProcess, &exitCode);
+    CloseHandle(processInfo.hProcess);
+    CloseHandle(processInfo.hThread);
+    return exitCode == 0;
+#else
+    // Build the environment list if one was specified
+    vector<char*> environmentList;
+    for (const auto& i : environment) {
+        environmentList.push_back(const_cast<char*>(i.c_str()));
+    }
+    environmentList.push_back(nullptr);
+
+    int inPipe[2], outPipe[2], errPipe[2];
+    pid_t pid;
+    int spawned;
+    {
+        // Create pipes for each of the standard streams which are only inherited through the file actions
+        lock_guard<mutex> lock(g_processMutex);
+        if (pipe(inPipe) != 0) {
+            return false;
+        }
+        if (pipe(outPipe) != 0) {
+            close(inPipe[0]);
+            close(inPipe[1]);
+            return false;
+        }
+        if (pipe(errPipe) != 0) {
+            close(inPipe[0]);
+            close(inPipe[1]);
+            close(outPipe[0]);
+            close(outPipe[1]);
+            return false;
+        }
+        for (int i : {inPipe[0], inPipe[1], outPipe[0], outPipe[1], errPipe[0], errPipe[1]}) {
+            fcntl(i, F_SETFD, FD_CLOEXEC);
+        }
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, inPipe[0], STDIN_FILENO);
+        posix_spawn_file_actions_adddup2(&actions, outPipe[1], STDOUT_FILENO);
+        posix_spawn_file_actions_adddup2(&actions, errPipe[1], STDERR_FILENO);
+        const char* args[] = {"/bin/sh", "-c", command.c_str(), nullptr};
+        spawned = posix_spawn(&pid, "/bin/sh", &actions, nullptr, const_cast<char* const*>(args),
+            environment.empty() ? environ : environmentList.data());
+        posix_spawn_file_actions_destroy(&actions);
+        close(inPipe[0]);
+        close(outPipe[1]);
+        close(errPipe[1]);
+    }
+    if (spawned != 0) {
+        close(inPipe[1]);
+        close(outPipe[0]);
+        close(errPipe[0]);
+        return false;
+    }
+
+    // Input and errors are handled on separate threads so that a full pipe can not block the child process
+    const auto readPipe = [](int pipe, string& retString) {
+        char buffer[65536];
+        ssize_t readSize;
+        while ((readSize = read(pipe, buffer, sizeof(buffer))) > 0) {
+            retString.append(buffer, readSize);
+        }
+    };
+    thread inputThread([&]() {
+        // Writing to a child that has already exited should fail instead of terminating the generator, so SIGPIPE is
+        // blocked for this thread only and any resulting signal is discarded before the previous mask is restored
+        sigset_t pipeSet, oldSet;
+        sigemptyset(&pipeSet);
+        sigaddset(&pipeSet, SIGPIPE);
+        pthread_sigmask(SIG_BLOCK, &pipeSet, &oldSet);
+        uint pos = 0;
+        ssize_t written;
+        while ((pos < input.length()) && ((written = write(inPipe[1], input.data() + pos, input.length() - pos)) > 0)) {
+            pos += written;
+        }
+        close(inPipe[1]);
+        sigset_t pending;
+        if ((sigpending(&pending) == 0) && (sigismember(&pending, SIGPIPE) == 1) &&
+            (sigismember(&oldSet, SIGPIPE) == 0)) {
+            int received;
+            sigwait(&pipeSet, &received);
+        }
+        pthread_sigmask(SIG_SETMASK, &oldSet, nullptr);
+    });
+    thread errorThread([&]() { readPipe(errPipe[0], errors); });
+    readPipe(outPipe[0], output);
+    inputThread.join();
+    errorThread.join();
+    close(outPipe[0]);
+    close(errPipe[0]);
+
+    int status;
+    if (waitpid(pid, &status, 0) != pid) {
+        return false;
+    }
+    return WIFEXITED(status) && (WEXITSTATUS(status) == 0);
+#endif
+}
+
+bool runProcesses(vector<ProcessJob>& jobs, const vector<string>& environment)
+{
+    // Each worker takes the next available job until all of them have been run
+    atomic<uint> nextJob(0);
+    const auto worker = [&]() {
+        uint job;
+        while ((job = nextJob++) < jobs.size()) {
+            ProcessJob& current = jobs[job];
+            current.success = runProcess(current.command, current.input, current.output, current.errors, environment);
+        }
+    };
+    const uint numWorkers = min<uint>(max(thread::hardware_concurrency(), 1U), jobs.size());
+    vector<thread> workers;
+    for (uint i = 1; i < numWorkers; i++) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& i : workers) {
+        i.join();
+    }
+    return all_of(jobs.begin(), jobs.end(), [](const ProcessJob& job) { return job.success; });
+}
+
 void pressKeyToContinue()
 {
 #if _WIN32
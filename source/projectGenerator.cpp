@@ -22,6 +22,7 @@
 
 #include <algorithm>
 #include <iomanip>
+#include <iterator>
 #include <sstream>
 #include <utility>
 
@@ -35,10 +36,23 @@
 #define TEMPLATE_PROG_FILTERS_ID 107
 #define TEMPLATE_STDATOMIC_ID 108
 #define TEMPLATE_BAT_ID 109
+#define TEMPLATE_PGO_BAT_ID 110
 
 bool ProjectGenerator::passAllMake()
 {
-    if ((m_configHelper.m_toolchain == "msvc") || (m_configHelper.m_toolchain == "icl")) {
+    // Variant configurations only benefit from AVX-512 assembly when it is supported by the assembler
+    const vector<string>& isaVariants = m_configHelper.m_isaVariants;
+    if ((find(isaVariants.begin(), isaVariants.end(), "AVX512") != isaVariants.end()) && !m_configHelper.m_useNASM) {
+        outputWarning("Yasm does not support AVX-512 so ReleaseAVX512 will only use compiler generated AVX-512 code");
+    }
+
+    // Load any per file compiler settings
+    if (!m_configHelper.m_fileSettings.empty() && !loadFileSettings()) {
+        return false;
+    }
+
+    if ((m_configHelper.m_toolchain == "msvc") || (m_configHelper.m_toolchain == "icl") ||
+        (m_configHelper.m_toolchain == "clang-cl")) {
         // Copy the required header files to output directory
         const bool copy = copyResourceFile(TEMPLATE_COMPAT_ID, m_configHelper.m_solutionDirectory + "compat.h", true);
         if (!copy) {
@@ -80,6 +94,17 @@ bool ProjectGenerator::passAllMake()
             }
             // Reset project dir so it does not include additions
             m_projectDir.resize(m_projectDir.length() - 4);
+            if (m_configHelper.m_useARM64) {
+                // Check for any aarch64 sub directories
+                m_projectDir += "aarch64/";
+                if (findFile(m_projectDir + "MakeFile", retFileName)) {
+                    // Pass the sub directory
+                    if (!passMake()) {
+                        return false;
+                    }
+                }
+                m_projectDir.resize(m_projectDir.length() - 8);
+            }
             // Output the project
             if (!outputProject()) {
                 return false;
@@ -93,14 +118,19 @@ bool ProjectGenerator::passAllMake()
         return false;
     }
 
+    // Output the ninja build file
+    if (m_configHelper.m_useNinja && !outputNinjaBuild()) {
+        return false;
+    }
+
     if (m_configHelper.m_onlyDCE) {
-        // Delete no longer needed compilation files
-        deleteCreatedFiles();
+        // Delete no longer needed compilation files (keeping those used by the ninja build file)
+        deleteCreatedFiles(m_configHelper.m_useNinja);
     }
     return true;
 }
 
-void ProjectGenerator::deleteCreatedFiles()
+void ProjectGenerator::deleteCreatedFiles(const bool staleOnly)
 {
     // Get list of libraries and programs
     vector<string> libraries;
@@ -118,11 +148,20 @@ void ProjectGenerator::deleteCreatedFiles()
     findFiles(m_configHelper.m_solutionDirectory + "stdatomic.h", existingFiles, false);
     findFiles(m_configHelper.m_solutionDirectory + "ffmpeg_with_latest_sdk.bat", existingFiles, false);
     findFiles(m_configHelper.m_solutionDirectory + "libav_with_latest_sdk.bat", existingFiles, false);
+    findFiles(m_configHelper.m_solutionDirectory + "ffmpeg_pgo_training.bat", existingFiles, false);
+    findFiles(m_configHelper.m_solutionDirectory + "libav_pgo_training.bat", existingFiles, false);
+    findFiles(m_configHelper.m_solutionDirectory + "build.ninja", existingFiles, false);
+    findFiles(m_configHelper.m_solutionDirectory + "ffmpeg_libraries.props", existingFiles, false);
+    findFiles(m_configHelper.m_solutionDirectory + "libav_libraries.props", existingFiles, false);
+    findFiles(m_configHelper.m_solutionDirectory + "ffmpeg_programs.props", existingFiles, false);
+    findFiles(m_configHelper.m_solutionDirectory + "libav_programs.props", existingFiles, false);
     for (auto& i : libraries) {
         i = "lib" + i;
         findFiles(m_configHelper.m_solutionDirectory + i + ".vcxproj", existingFiles, false);
         findFiles(m_configHelper.m_solutionDirectory + i + ".vcxproj.filters", existingFiles, false);
         findFiles(m_configHelper.m_solutionDirectory + i + ".def", existingFiles, false);
+        findFiles(m_configHelper.m_solutionDirectory + i + "_shard*.vcxproj", existingFiles, false);
+        findFiles(m_configHelper.m_solutionDirectory + i + "_shard*.vcxproj.filters", existingFiles, false);
     }
     for (const auto& i : programs) {
         findFiles(m_configHelper.m_solutionDirectory + i + ".vcxproj", existingFiles, false);
@@ -130,13 +169,16 @@ void ProjectGenerator::deleteCreatedFiles()
         findFiles(m_configHelper.m_solutionDirectory + i + ".def", existingFiles, false);
     }
     for (const auto& i : existingFiles) {
-        deleteFile(i);
+        if (!staleOnly || !isFileWritten(i)) {
+            deleteFile(i);
+        }
     }
 
     // Check for any created folders
     vector<string> existingFolders;
     for (const auto& i : libraries) {
         findFolders(m_configHelper.m_solutionDirectory + i, existingFolders, false);
+        findFolders(m_configHelper.m_solutionDirectory + i + "_shard*", existingFolders, false);
     }
     for (const auto& i : programs) {
         findFolders(m_configHelper.m_solutionDirectory + i, existingFolders, false);
@@ -146,17 +188,44 @@ void ProjectGenerator::deleteCreatedFiles()
         existingFiles.resize(0);
         findFiles(i + "/dce_defs.c", existingFiles, false);
         findFiles(i + "/*_wrap.c", existingFiles, false);
+        findFiles(i + "/unity_*.c", existingFiles, false);
+        findFiles(i + "/pch.h", existingFiles, false);
+        findFiles(i + "/pch.c", existingFiles, false);
         if (!m_configHelper.m_usingExistingConfig) {
             findFiles(i + "/*_list.c", existingFiles, false);
         }
         for (auto& j : existingFiles) {
-            deleteFile(j);
+            if (!staleOnly || !isFileWritten(j)) {
+                deleteFile(j);
+            }
         }
         // Check if the directory is now empty and delete if it is
         if (isFolderEmpty(i)) {
             deleteFolder(i);
         }
     }
+
+    // Remove any cached results that are no longer used
+    deletePreProcessorCache(true);
+}
+
+void ProjectGenerator::deletePreProcessorCache(const bool unusedOnly)
+{
+    const string cacheFolder = m_configHelper.m_solutionDirectory + m_cacheDirectory;
+    vector<string> cacheFiles;
+    findFiles(cacheFolder + "*", cacheFiles, false);
+    for (const auto& i : cacheFiles) {
+        const string key = i.substr(i.rfind('/') + 1);
+        if (key.empty() || (key.at(0) == '.')) {
+            continue;
+        }
+        if (!unusedOnly || (m_cacheKeys.find(key) == m_cacheKeys.end())) {
+            deleteFile(i);
+        }
+    }
+    if (isFolderEmpty(cacheFolder)) {
+        deleteFolder(cacheFolder);
+    }
 }
 
 void ProjectGenerator::errorFunc(const bool cleanupFiles)
@@ -165,6 +234,7 @@ void ProjectGenerator::errorFunc(const bool cleanupFiles)
         // Cleanup any partially created files
         m_configHelper.deleteCreatedFiles();
         deleteCreatedFiles();
+        deletePreProcessorCache(false);
 
         // Delete any temporary file leftovers
         deleteFolder(m_tempDirectory);
@@ -197,7 +267,7 @@ bool ProjectGenerator::outputProject()
         return false;
     }
 
-    if (m_configHelper.m_onlyDCE) {
+    if (m_configHelper.m_onlyDCE && !m_configHelper.m_useNinja) {
         // Exit here to prevent outputting project files
         return true;
     }
@@ -207,62 +277,79 @@ bool ProjectGenerator::outputProject()
         return false;
     }
 
-    // We now have complete list of all the files that we need
-    outputLine("  Generating project file (" + m_projectName + ")...");
-
-    // Open the input temp project file
-    string projectFile;
-    if (!loadFromResourceFile(TEMPLATE_VCXPROJ_ID, projectFile)) {
+    // Add the project to the ninja build file
+    if (m_configHelper.m_useNinja && !outputNinjaProject(includeDirs, defines, false)) {
         return false;
     }
 
-    // Open the input temp project file filters
-    string filtersFile;
-    if (!loadFromResourceFile(TEMPLATE_FILTERS_ID, filtersFile)) {
+    if (m_configHelper.m_onlyDCE) {
+        // Exit here to prevent outputting project files
+        return true;
+    }
+
+    // Move sources into any shard projects
+    if (!outputProjectShards(includeDirs, defines)) {
         return false;
     }
 
-    // Remove any winrt configurations if not requested
-    if (!m_configHelper.isConfigOptionEnabled("WINRT") && !m_configHelper.isConfigOptionEnabled("UWP")) {
-        outputStripWinRT(projectFile);
+    // We now have complete list of all the files that we need
+    outputLine("  Generating project file (" + m_projectName + ")...");
+
+    // Replace all template tag arguments
+    TemplateSlots slots;
+    outputTemplateTags(slots);
+
+    // Create the precompiled header (must be before source files are added)
+    if (!createPrecompiledHeader(slots)) {
+        return false;
     }
 
     // Add all project source files
-    outputSourceFiles(projectFile, filtersFile);
+    if (!outputSourceFiles(slots)) {
+        return false;
+    }
 
     // Add the build events
-    outputBuildEvents(projectFile);
+    outputBuildEvents(slots);
 
     // Add ASM requirements
-    outputASMTools(projectFile);
+    outputASMTools(slots);
 
     // Add CUDA requirements
-    outputCUDATools(projectFile);
+    outputCUDATools(slots);
 
     // Add the dependency libraries
-    if (!outputDependencyLibs(projectFile)) {
+    outputDependencyLibs(slots);
+
+    // Add references to the dependency library projects
+    if (!outputProjectReferences(slots)) {
         return false;
     }
 
     // Add additional includes to include list
-    outputIncludeDirs(includeDirs, projectFile);
+    outputIncludeDirs(includeDirs, slots);
 
     // Add additional lib includes to include list
-    outputLibDirs(lib32Dirs, lib64Dirs, projectFile);
+    outputLibDirs(lib32Dirs, lib64Dirs, slots);
 
     // Add additional defines
-    outputDefines(defines, projectFile);
-
-    // Replace all template tag arguments
-    outputTemplateTags(projectFile, filtersFile);
+    outputDefines(defines, slots);
 
     // Write output project
+    string projectFile;
+    if (!outputTemplate(TEMPLATE_VCXPROJ_ID, slots, projectFile)) {
+        return false;
+    }
     const string outProjectFile = m_configHelper.m_solutionDirectory + m_projectName + ".vcxproj";
     if (!writeToFile(outProjectFile, projectFile, true)) {
         return false;
     }
 
     // Write output filters
+    string filtersFile;
+    if (!outputTemplate(TEMPLATE_FILTERS_ID, slots, filtersFile)) {
+        return false;
+    }
     const string outFiltersFile = m_configHelper.m_solutionDirectory + m_projectName + ".vcxproj.filters";
     return writeToFile(outFiltersFile, filtersFile, true);
 }
@@ -291,61 +378,64 @@ bool ProjectGenerator::outputProgramProject(const string& destinationFile, const
         return false;
     }
 
+    // Add the program to the ninja build file
+    if (m_configHelper.m_useNinja && !outputNinjaProject(includeDirs, defines, true)) {
+        return false;
+    }
+
     if (m_configHelper.m_onlyDCE) {
         // Exit here to prevent outputting project files
+        outputProjectCleanup();
         return true;
     }
 
     // We now have complete list of all the files that we need
     outputLine("  Generating project file (" + m_projectName + ")...");
 
-    // Open the template program
-    string programFile;
-    if (!loadFromResourceFile(TEMPLATE_PROG_VCXPROJ_ID, programFile)) {
-        return false;
-    }
+    // Replace all template tag arguments
+    TemplateSlots slots;
+    outputTemplateTags(slots);
 
-    // Open the template program filters
-    string programFiltersFile;
-    if (!loadFromResourceFile(TEMPLATE_PROG_FILTERS_ID, programFiltersFile)) {
+    // Add all project source files
+    if (!outputSourceFiles(slots)) {
         return false;
     }
 
-    // Add all project source files
-    outputSourceFiles(programFile, programFiltersFile);
-
     // Add the build events
-    outputBuildEvents(programFile);
+    outputBuildEvents(slots);
 
     // Add ASM requirements
-    outputASMTools(programFile);
+    outputASMTools(slots);
 
     // Add CUDA requirements
-    outputCUDATools(programFile);
+    outputCUDATools(slots);
 
     // Add the dependency libraries
-    if (!outputDependencyLibs(programFile, true)) {
-        return false;
-    }
+    outputDependencyLibs(slots);
 
     // Add additional includes to include list
-    outputIncludeDirs(includeDirs, programFile);
+    outputIncludeDirs(includeDirs, slots);
 
     // Add additional lib includes to include list
-    outputLibDirs(lib32Dirs, lib64Dirs, programFile);
+    outputLibDirs(lib32Dirs, lib64Dirs, slots);
 
     // Add additional defines
-    outputDefines(defines, programFile);
-
-    // Replace all template tag arguments
-    outputTemplateTags(programFile, programFiltersFile);
+    outputDefines(defines, slots);
 
     // Write program file
+    string programFile;
+    if (!outputTemplate(TEMPLATE_PROG_VCXPROJ_ID, slots, programFile)) {
+        return false;
+    }
     if (!writeToFile(destinationFile, programFile, true)) {
         return false;
     }
 
     // Write output filters
+    string programFiltersFile;
+    if (!outputTemplate(TEMPLATE_PROG_FILTERS_ID, slots, programFiltersFile)) {
+        return false;
+    }
     if (!writeToFile(destinationFilterFile, programFiltersFile, true)) {
         return false;
     }
@@ -355,6 +445,157 @@ bool ProjectGenerator::outputProgramProject(const string& destinationFile, const
     return true;
 }
 
+bool ProjectGenerator::outputProjectShards(const StaticList& includeDirs, const StaticList& defines)
+{
+    m_projectShards.erase(m_projectName);
+    if (m_configHelper.m_shardCount < 2) {
+        return true;
+    }
+
+    // Get the cost of each source file that can be moved into a shard
+    const string generatedDir = m_projectName + '/';
+    vector<pair<uint, string>> sources;
+    const StaticList* sourceLists[] = {&m_includesC, &m_includesASM};
+    for (const auto& i : sourceLists) {
+        for (const auto& j : *i) {
+            // Generated files are kept in the current project
+            if (j.find(generatedDir) == 0) {
+                continue;
+            }
+            string file;
+            if (!loadFromFile(m_configHelper.m_solutionDirectory + j, file)) {
+                return false;
+            }
+            sources.emplace_back(file.length(), j);
+        }
+    }
+
+    // Only split the project when each shard has enough sources to be worth building separately
+    const uint minShardSources = 100;
+    const uint shardCount = min(m_configHelper.m_shardCount, static_cast<uint>(sources.size() / minShardSources));
+    if (shardCount < 2) {
+        return true;
+    }
+
+    // The current project must still have something to compile so the smallest source is kept if needed
+    stable_sort(sources.begin(), sources.end(),
+        [](const pair<uint, string>& a, const pair<uint, string>& b) { return a.first > b.first; });
+    bool hasSources = !m_includesCPP.empty();
+    for (const auto& i : m_includesC) {
+        hasSources = hasSources || (i.find(generatedDir) == 0);
+    }
+    if (!hasSources) {
+        sources.pop_back();
+    }
+
+    // Assign the largest sources first to the shard with the lowest total cost
+    vector<uint> shardCosts(shardCount, 0);
+    map<string, uint> sourceShards;
+    for (const auto& i : sources) {
+        const uint shard = min_element(shardCosts.begin(), shardCosts.end()) - shardCosts.begin();
+        shardCosts[shard] += i.first;
+        sourceShards[i.second] = shard;
+    }
+
+    // Output each shard using the same sources order as the current project
+    const string projectName = m_projectName;
+    const StaticList includesC = m_includesC;
+    const StaticList includesASM = m_includesASM;
+    const StaticList includesCPP = m_includesCPP;
+    const StaticList includesH = m_includesH;
+    const StaticList includesCU = m_includesCU;
+    StaticList& shards = m_projectShards[projectName];
+    for (uint i = 0; i < shardCount; i++) {
+        shards.push_back(projectName + "_shard" + to_string(i + 1));
+    }
+    for (uint i = 0; i <= shardCount; i++) {
+        m_includesC.clear();
+        m_includesASM.clear();
+        for (uint j = 0; j < 2; j++) {
+            const StaticList& sourceList = (j == 0) ? includesC : includesASM;
+            StaticList& shardList = (j == 0) ? m_includesC : m_includesASM;
+            for (const auto& k : sourceList) {
+                const auto shard = sourceShards.find(k);
+                if (((shard != sourceShards.end()) ? shard->second : shardCount) == i) {
+                    shardList.push_back(k);
+                }
+            }
+        }
+        if (i == shardCount) {
+            // The remaining sources are kept in the current project
+            break;
+        }
+        m_includesCPP.clear();
+        m_includesH.clear();
+        m_includesCU.clear();
+        m_sourceFileSettings.clear();
+        m_projectName = shards[i];
+        outputLine("  Generating project file (" + m_projectName + ")...");
+
+        // Replace all template tag arguments
+        TemplateSlots slots;
+        outputTemplateTags(slots);
+
+        // Create the precompiled header (must be before source files are added)
+        if (!createPrecompiledHeader(slots)) {
+            return false;
+        }
+
+        // Add all project source files
+        if (!outputSourceFiles(slots)) {
+            return false;
+        }
+
+        // Shards have no build events but still need the ASM requirements
+        slots["buildEvents"].push_back("");
+        outputASMTools(slots);
+        // Add additional includes to include list
+        outputIncludeDirs(includeDirs, slots);
+
+        // Add additional defines
+        outputDefines(defines, slots);
+
+        // Write output project
+        string projectFile;
+        if (!outputTemplate(TEMPLATE_VCXPROJ_ID, slots, projectFile)) {
+            return false;
+        }
+        outputConvertShard(projectFile);
+        // Sources are compiled as part of the current library
+        findAndReplace(projectFile, "BUILDING_" + m_projectName.substr(3), "BUILDING_" + projectName.substr(3));
+        const string outProjectFile = m_configHelper.m_solutionDirectory + m_projectName + ".vcxproj";
+        if (!writeToFile(outProjectFile, projectFile, true)) {
+            return false;
+        }
+
+        // Write output filters
+        string filtersFile;
+        if (!outputTemplate(TEMPLATE_FILTERS_ID, slots, filtersFile)) {
+            return false;
+        }
+        const string outFiltersFile = m_configHelper.m_solutionDirectory + m_projectName + ".vcxproj.filters";
+        if (!writeToFile(outFiltersFile, filtersFile, true)) {
+            return false;
+        }
+    }
+    m_projectName = projectName;
+    m_includesCPP = includesCPP;
+    m_includesH = includesH;
+    m_includesCU = includesCU;
+    m_sourceFileSettings.clear();
+    return true;
+}
+
+string ProjectGenerator::getLibraryName() const
+{
+    for (const auto& i : m_projectShards) {
+        if (find(i.second.begin(), i.second.end(), m_projectName) != i.second.end()) {
+            return i.first;
+        }
+    }
+    return m_projectName;
+}
+
 void ProjectGenerator::outputProjectCleanup()
 {
     // Reset all internal values
@@ -364,8 +605,10 @@ void ProjectGenerator::outputProjectCleanup()
     m_includesCPP.clear();
     m_includesC.clear();
     m_includesASM.clear();
+    m_includesGAS.clear();
     m_includesH.clear();
     m_includesCU.clear();
+    m_sourceFileSettings.clear();
     m_libs.clear();
     m_unknowns.clear();
     m_projectDir.clear();
@@ -406,17 +649,6 @@ bool ProjectGenerator::outputSolution()
     }
 
     outputLine("  Generating solution file...");
-    // Open the input temp project file
-    string solutionFile;
-    if (!loadFromResourceFile(TEMPLATE_SLN_ID, solutionFile)) {
-        return false;
-    }
-
-    // Remove any winrt configurations if not requested
-    if (!m_configHelper.isConfigOptionEnabled("winrt") && !m_configHelper.isConfigOptionEnabled("uwp")) {
-        outputStripWinRTSolution(solutionFile);
-    }
-
     map<string, string> keys;
     buildProjectGUIDs(keys);
     string solutionKey = "8BC9CEB8-8B4A-11D0-8D11-00A0C91BC942";
@@ -436,9 +668,7 @@ bool ProjectGenerator::outputSolution()
     const string subDepend2 = "} = {";
     const string subDependEnd = "}";
 
-    // Find the start of the file
-    const string fileStart = "Project";
-    uint pos = solutionFile.find(fileStart) - 2;
+    string projects;
     for (const auto& i : m_projectLibs) {
         // Check if this is a library or a program
         if (programList.find(i.first) == programList.end()) {
@@ -461,28 +691,30 @@ bool ProjectGenerator::outputSolution()
             // Add the key to the used key list
             addedKeys.push_back(keys[i.first]);
 
-            // Add the dependencies
-            if (i.second.size() > 0) {
-                projectAdd += depend;
-                for (auto& j : i.second) {
-                    // Check if this library has a known key
-                    if (keys.find(j) == keys.end()) {
-                        outputError("Unknown library dependency. Could not determine solution key (" + j + ")");
-                        return false;
-                    }
-                    projectAdd += subDepend;
-                    projectAdd += keys[j];
-                    projectAdd += subDepend2;
+            // Library dependencies are only needed when linking a dll so they are added as project references that
+            // are conditional on the configuration instead. This allows static libraries to be built in parallel
+            projectAdd += projectClose;
+
+            // Add any shards of the library which are always built before the library itself
+            const auto shards = m_projectShards.find(i.first);
+            if (shards != m_projectShards.end()) {
+                for (const auto& j : shards->second) {
+                    projectAdd += project;
+                    projectAdd += solutionKey;
+                    projectAdd += project2;
+                    projectAdd += j;
+                    projectAdd += project3;
+                    projectAdd += j;
+                    projectAdd += project4;
                     projectAdd += keys[j];
-                    projectAdd += subDependEnd;
+                    projectAdd += projectEnd;
+                    projectAdd += projectClose;
+                    addedKeys.push_back(keys[j]);
                 }
-                projectAdd += dependClose;
             }
-            projectAdd += projectClose;
 
-            // Insert into solution string
-            solutionFile.insert(pos, projectAdd);
-            pos += projectAdd.length();
+            // Add to the solution projects
+            projects += projectAdd;
         }
     }
 
@@ -535,23 +767,27 @@ bool ProjectGenerator::outputSolution()
         projectAdd += "}\"";
         projectAdd += "\r\nEndProject";
 
-        // Insert into solution string
-        solutionFile.insert(pos, projectAdd);
+        // Add to the solution projects
+        projects += projectAdd;
     }
+    TemplateSlots slots;
+    slots["projects"].push_back(projects);
 
     // Check if winrt builds are enabled
     bool addWinrt = m_configHelper.isConfigOptionEnabled("winrt") || m_configHelper.isConfigOptionEnabled("uwp");
 
     // Next Add the solution configurations
-    string configStart = "GlobalSection(ProjectConfigurationPlatforms) = postSolution";
-    pos = solutionFile.find(configStart) + configStart.length();
     string configPlatform = "\r\n		{";
     string configPlatform2 = "}.";
     string configPlatform3 = "|";
     string buildConfigs[10] = {"Debug", "DebugDLL", "DebugDLLWinRT", "DebugWinRT", "Release", "ReleaseDLL",
         "ReleaseDLLStaticDeps", "ReleaseDLLWinRT", "ReleaseDLLWinRTStaticDeps", "ReleaseWinRT"};
-    string buildArchsSol[2] = {"x86", "x64"};
-    string buildArchs[2] = {"Win32", "x64"};
+    StaticList buildArchsSol = {"x86", "x64"};
+    StaticList buildArchs = {"Win32", "x64"};
+    if (m_configHelper.m_useARM64) {
+        buildArchsSol.emplace_back("ARM64");
+        buildArchs.emplace_back("ARM64");
+    }
     string buildTypes[2] = {".ActiveCfg = ", ".Build.0 = "};
     string addPlatform;
     // Add the lib keys
@@ -561,7 +797,11 @@ bool ProjectGenerator::outputSolution()
             // Skip winrt configs if not enabled
             if ((buildConfigs[j].find("WinRT") == string::npos) || addWinrt) {
                 // loop over build archs
-                for (uint k = 0; k < 2; k++) {
+                for (uint k = 0; k < buildArchs.size(); k++) {
+                    // Skip any configurations that have not been requested
+                    if (!isConfigurationEnabled(buildConfigs[j] + configPlatform3 + buildArchs[k], false)) {
+                        continue;
+                    }
                     // loop over build types
                     for (const auto& aBuildType : buildTypes) {
                         addPlatform += configPlatform;
@@ -587,7 +827,11 @@ bool ProjectGenerator::outputSolution()
             // Skip winrt configs if not enabled
             if ((buildConfigs[j].find("WinRT") == string::npos) || addWinrt) {
                 // Loop over build archs
-                for (uint k = 0; k < sizeof(buildArchsSol) / sizeof(buildArchsSol[0]); k++) {
+                for (uint k = 0; k < buildArchsSol.size(); k++) {
+                    // Skip any configurations that have not been requested
+                    if (!isConfigurationEnabled(buildConfigs[j] + configPlatform3 + buildArchs[k], false)) {
+                        continue;
+                    }
                     // Loop over build types
                     for (uint m = 0; m < sizeof(buildTypes) / sizeof(buildTypes[0]); m++) {
                         if ((m == 1) && (j != 4)) {
@@ -623,13 +867,62 @@ bool ProjectGenerator::outputSolution()
             }
         }
     }
-    // Insert into solution string
-    solutionFile.insert(pos, addPlatform);
+
+    // Add the profile guided optimisation configurations which are built for every project
+    if (m_configHelper.m_usePGO) {
+        vector<string> allKeys = addedKeys;
+        allKeys.insert(allKeys.end(), addedPrograms.begin(), addedPrograms.end());
+        const string pgoConfigs[] = {"ReleasePGInstrument", "ReleasePGOptimize"};
+        for (const auto& i : allKeys) {
+            for (const auto& j : pgoConfigs) {
+                for (uint k = 0; k < buildArchsSol.size(); k++) {
+                    if (!isConfigurationEnabled(j + configPlatform3 + buildArchs[k], false)) {
+                        continue;
+                    }
+                    for (const auto& aBuildType : buildTypes) {
+                        addPlatform += configPlatform;
+                        addPlatform += i;
+                        addPlatform += configPlatform2;
+                        addPlatform += j;
+                        addPlatform += configPlatform3;
+                        addPlatform += buildArchsSol[k];
+                        addPlatform += aBuildType;
+                        addPlatform += j;
+                        addPlatform += configPlatform3;
+                        addPlatform += buildArchs[k];
+                    }
+                }
+            }
+        }
+    }
+
+    // Add the instruction set variant configurations which are only built for x64
+    for (const auto& i : m_configHelper.m_isaVariants) {
+        vector<string> allKeys = addedKeys;
+        allKeys.insert(allKeys.end(), addedPrograms.begin(), addedPrograms.end());
+        const string configuration = "Release" + i;
+        if (!isConfigurationEnabled(configuration + configPlatform3 + buildArchs[1], false)) {
+            continue;
+        }
+        for (const auto& j : allKeys) {
+            for (const auto& aBuildType : buildTypes) {
+                addPlatform += configPlatform;
+                addPlatform += j;
+                addPlatform += configPlatform2;
+                addPlatform += configuration;
+                addPlatform += configPlatform3;
+                addPlatform += buildArchsSol[1];
+                addPlatform += aBuildType;
+                addPlatform += configuration;
+                addPlatform += configPlatform3;
+                addPlatform += buildArchs[1];
+            }
+        }
+    }
+    slots["configurations"].push_back(addPlatform);
 
     // Add any programs to the nested projects
     if (addedPrograms.size() > 0) {
-        string nestedStart = "GlobalSection(NestedProjects) = preSolution";
-        uint pos2 = solutionFile.find(nestedStart) + nestedStart.length();
         string nest = "\r\n		{";
         string nest2 = "} = {";
         string nestEnd = "}";
@@ -641,11 +934,14 @@ bool ProjectGenerator::outputSolution()
             nestProg += programKey;
             nestProg += nestEnd;
         }
-        // Insert into solution string
-        solutionFile.insert(pos2, nestProg);
+        slots["nested"].push_back(nestProg);
     }
 
     // Write output solution
+    string solutionFile;
+    if (!outputTemplate(TEMPLATE_SLN_ID, slots, solutionFile)) {
+        return false;
+    }
     string projectName = m_configHelper.m_projectName;
     transform(projectName.begin(), projectName.end(), projectName.begin(), tolower);
     const string outSolutionFile = m_configHelper.m_solutionDirectory + projectName + ".sln";
@@ -654,135 +950,406 @@ bool ProjectGenerator::outputSolution()
     }
 
     outputLine("  Generating SDK batch file...");
-    // Open the input temp project file
+    // Change all occurrences of template_in with solution name
+    TemplateSlots batSlots;
+    batSlots["template_in"].push_back(projectName);
     string batFile;
-    if (!loadFromResourceFile(TEMPLATE_BAT_ID, batFile)) {
+    if (!outputTemplate(TEMPLATE_BAT_ID, batSlots, batFile)) {
         return false;
     }
 
-    // Change all occurrences of template_in with solution name
-    const string searchTag = "template_in";
-    uint findPos = batFile.find(searchTag);
-    while (findPos != string::npos) {
-        // Replace
-        batFile.replace(findPos, searchTag.length(), projectName);
-        // Get next
-        findPos = batFile.find(searchTag, findPos + 1);
-    }
-
     // Write to output
     const string outBatFile = m_configHelper.m_solutionDirectory + projectName + "_with_latest_sdk.bat";
     if (!writeToFile(outBatFile, batFile, true)) {
         return false;
     }
 
+    // Write any props files shared between projects
+    for (const auto& i : m_propsFiles) {
+        outputLine("  Generating props file (" + i.first + ")...");
+        if (!writeToFile(m_configHelper.m_solutionDirectory + i.first, i.second, true)) {
+            return false;
+        }
+    }
+
+    if (m_configHelper.m_usePGO) {
+        // The training workload is run using the first program
+        const auto program = programList.begin();
+        if (m_configHelper.getConfigOptionPrefixed(program->second)->m_value.compare("1") != 0) {
+            outputWarning("PGO training batch file not generated as " + program->first + " is disabled");
+            return true;
+        }
+        outputLine("  Generating PGO training batch file...");
+        string outDir = m_configHelper.m_outDirectory;
+        replace(outDir.begin(), outDir.end(), '/', '\\');
+        if (outDir.back() == '\\') {
+            outDir.pop_back();
+        }
+        if (outDir.at(0) == '.') {
+            outDir = "%~dp0" + outDir; // Make any relative paths based on the batch file location
+        }
+        TemplateSlots pgoSlots;
+        pgoSlots["template_in"].push_back(projectName);
+        pgoSlots["template_program"].push_back(program->first);
+        pgoSlots["template_outdir"].push_back(outDir);
+        string pgoFile;
+        if (!outputTemplate(TEMPLATE_PGO_BAT_ID, pgoSlots, pgoFile)) {
+            return false;
+        }
+        const string outPGOFile = m_configHelper.m_solutionDirectory + projectName + "_pgo_training.bat";
+        if (!writeToFile(outPGOFile, pgoFile, true)) {
+            return false;
+        }
+    }
     return true;
 }
 
-void ProjectGenerator::outputTemplateTags(string& projectTemplate, string& filtersTemplate) const
+bool ProjectGenerator::buildTemplate(const int resourceID)
 {
-    // Change all occurrences of template_in with project name
-    const string searchTag = "template_in";
-    uint findPos = projectTemplate.find(searchTag);
-    while (findPos != string::npos) {
-        // Replace
-        projectTemplate.replace(findPos, searchTag.length(), m_projectName);
-        // Get next
-        findPos = projectTemplate.find(searchTag, findPos + 1);
+    if (m_templates.find(resourceID) != m_templates.end()) {
+        return true;
     }
-    uint findPosFilt = filtersTemplate.find(searchTag);
-    while (findPosFilt != string::npos) {
-        // Replace
-        filtersTemplate.replace(findPosFilt, searchTag.length(), m_projectName);
-        // Get next
-        findPosFilt = filtersTemplate.find(searchTag, findPosFilt + 1);
+
+    // Open the input template
+    string templateFile;
+    if (!loadFromResourceFile(resourceID, templateFile)) {
+        return false;
     }
 
-    // Change all occurrences of template_shin with short project name
-    const string shortSearchTag = "template_shin";
-    findPos = projectTemplate.find(shortSearchTag);
-    string projectNameShort = m_projectName.substr(3); // The full name minus the lib prefix
-    while (findPos != string::npos) {
-        // Replace
-        projectTemplate.replace(findPos, shortSearchTag.length(), projectNameShort);
-        // Get next
-        findPos = projectTemplate.find(shortSearchTag, findPos + 1);
+    // Remove any winrt configurations if not requested
+    if (!m_configHelper.isConfigOptionEnabled("winrt") && !m_configHelper.isConfigOptionEnabled("uwp")) {
+        if (resourceID == TEMPLATE_VCXPROJ_ID) {
+            outputStripWinRT(templateFile);
+        } else if (resourceID == TEMPLATE_SLN_ID) {
+            outputStripWinRTSolution(templateFile);
+        }
     }
-    findPosFilt = filtersTemplate.find(shortSearchTag);
-    while (findPosFilt != string::npos) {
-        // Replace
-        filtersTemplate.replace(findPosFilt, shortSearchTag.length(), projectNameShort);
-        // Get next
-        findPosFilt = filtersTemplate.find(shortSearchTag, findPosFilt + 1);
+
+    // Add any ARM64 configurations
+    if (m_configHelper.m_useARM64) {
+        if ((resourceID == TEMPLATE_VCXPROJ_ID) || (resourceID == TEMPLATE_PROG_VCXPROJ_ID)) {
+            outputAddARM64(templateFile);
+        } else if (resourceID == TEMPLATE_SLN_ID) {
+            outputAddARM64Solution(templateFile);
+        }
     }
 
-    // Change all occurrences of template_platform with specified project toolchain
-    string toolchain = "<PlatformToolset Condition=\"'$(VisualStudioVersion)'=='12.0'\">v120</PlatformToolset>\r\n\
-    <PlatformToolset Condition=\"'$(VisualStudioVersion)'=='14.0'\">v140</PlatformToolset>\r\n\
-    <PlatformToolset Condition=\"'$(VisualStudioVersion)'=='15.0'\">v141</PlatformToolset>\r\n\
-    <PlatformToolset Condition=\"'$(VisualStudioVersion)'=='16.0'\">v142</PlatformToolset>";
-    if (m_configHelper.m_toolchain.compare("msvc") != 0) {
-        toolchain +=
-            "\r\n    <PlatformToolset Condition=\"'$(ICPP_COMPILER13)'!=''\">Intel C++ Compiler XE 13.0</PlatformToolset>\r\n\
-    <PlatformToolset Condition=\"'$(ICPP_COMPILER14)'!=''\">Intel C++ Compiler XE 14.0</PlatformToolset>\r\n\
-    <PlatformToolset Condition=\"'$(ICPP_COMPILER15)'!=''\">Intel C++ Compiler XE 15.0</PlatformToolset>\r\n\
-    <PlatformToolset Condition=\"'$(ICPP_COMPILER16)'!=''\">Intel C++ Compiler 16.0</PlatformToolset>\r\n\
-    <PlatformToolset Condition=\"'$(ICPP_COMPILER17)'!=''\">Intel C++ Compiler 17.0</PlatformToolset>\r\n\
-    <PlatformToolset Condition=\"'$(ICPP_COMPILER18)'!=''\">Intel C++ Compiler 18.0</PlatformToolset>\r\n\
-    <PlatformToolset Condition=\"'$(ICPP_COMPILER19)'!=''\">Intel C++ Compiler 19.0</PlatformToolset>";
+    // Add any profile guided optimisation configurations
+    if (m_configHelper.m_usePGO) {
+        if ((resourceID == TEMPLATE_VCXPROJ_ID) || (resourceID == TEMPLATE_PROG_VCXPROJ_ID)) {
+            outputAddPGO(templateFile);
+        } else if (resourceID == TEMPLATE_SLN_ID) {
+            outputAddPGOSolution(templateFile);
+        }
     }
 
-    const string platformSearch = "<PlatformToolset>template_platform</PlatformToolset>";
-    findPos = projectTemplate.find(platformSearch);
-    while (findPos != string::npos) {
-        // Replace
-        projectTemplate.replace(findPos, platformSearch.length(), toolchain);
-        // Get next
-        findPos = projectTemplate.find(platformSearch, findPos + platformSearch.length());
+    // Add any instruction set variant configurations
+    if (!m_configHelper.m_isaVariants.empty()) {
+        if ((resourceID == TEMPLATE_VCXPROJ_ID) || (resourceID == TEMPLATE_PROG_VCXPROJ_ID)) {
+            outputAddISA(templateFile);
+        } else if (resourceID == TEMPLATE_SLN_ID) {
+            outputAddISASolution(templateFile);
+        }
     }
 
-    // Set the project key
-    string projectGuid = "<ProjectGuid>{";
-    findPos = projectTemplate.find(projectGuid);
-    if (findPos != string::npos) {
-        map<string, string> keys;
-        buildProjectGUIDs(keys);
-        findPos += projectGuid.length();
-        projectTemplate.replace(findPos, keys[m_projectName].length(), keys[m_projectName]);
+    // Remove any configurations that have not been requested
+    if (!m_configHelper.m_configurations.empty() || !m_configHelper.m_platforms.empty()) {
+        if ((resourceID == TEMPLATE_VCXPROJ_ID) || (resourceID == TEMPLATE_PROG_VCXPROJ_ID)) {
+            outputStripConfigurations(templateFile, resourceID == TEMPLATE_PROG_VCXPROJ_ID);
+        } else if (resourceID == TEMPLATE_SLN_ID) {
+            outputStripConfigurationsSolution(templateFile);
+        }
     }
 
-    // Change all occurrences of template_outdir with configured output directory
-    string outDir = m_configHelper.m_outDirectory;
-    replace(outDir.begin(), outDir.end(), '/', '\\');
-    if (outDir.at(0) == '.') {
-        outDir = "$(ProjectDir)" + outDir; // Make any relative paths based on project dir
+    // Move the common settings of every project into a shared props file
+    if (m_configHelper.m_useProps && ((resourceID == TEMPLATE_VCXPROJ_ID) || (resourceID == TEMPLATE_PROG_VCXPROJ_ID))) {
+        string propsName = m_configHelper.m_projectName;
+        transform(propsName.begin(), propsName.end(), propsName.begin(), tolower);
+        propsName += (resourceID == TEMPLATE_PROG_VCXPROJ_ID) ? "_programs.props" : "_libraries.props";
+        string& propsFile = m_propsFiles[propsName];
+        outputSplitProps(templateFile, propsName, propsFile);
     }
-    const string outSearchTag = "template_outdir";
-    findPos = projectTemplate.find(outSearchTag);
-    while (findPos != string::npos) {
-        // Replace
-        projectTemplate.replace(findPos, outSearchTag.length(), outDir);
-        // Get next
-        findPos = projectTemplate.find(outSearchTag, findPos + 1);
+
+    // Find the position of every slot in the template
+    multimap<uint, pair<string, uint>> positions;
+    if ((resourceID == TEMPLATE_VCXPROJ_ID) || (resourceID == TEMPLATE_PROG_VCXPROJ_ID)) {
+        const string tags[] = {"template_in", "template_shin", "template_outdir", "template_rootdir",
+            "template_winver32", "template_winver64", "template_winnt32", "template_winnt64"};
+        for (const auto& i : tags) {
+            buildTemplateSlots(templateFile, i, i, true, positions);
+        }
+        buildTemplateSlots(templateFile, "<PlatformToolset>template_platform</PlatformToolset>", "template_platform",
+            true, positions);
+        // The project key replaces the existing key in the template
+        const string projectGuid = "<ProjectGuid>{";
+        uint findPos = templateFile.find(projectGuid);
+        if (findPos != string::npos) {
+            findPos += projectGuid.length();
+            positions.emplace(findPos, make_pair("template_guid", templateFile.find('}', findPos) - findPos));
+        }
+        // After the last </ItemGroup> add the item groups for each of the source types
+        const string endTag = "</ItemGroup>";
+        findPos = templateFile.rfind(endTag);
+        positions.emplace(findPos + endTag.length(), make_pair("sources", 0));
+        // Add the build events (and asm defines) after </Lib> and </Link>
+        buildTemplateSlots(templateFile, "</Lib>", "buildEvents", false, positions);
+        buildTemplateSlots(templateFile, "</Link>", "buildEvents", false, positions);
+        // After <Import Project="$(VCTargetsPath)\Microsoft.Cpp.props" /> add asm props
+        const string findProps = R"(<Import Project="$(VCTargetsPath)\Microsoft.Cpp.props" />)";
+        findPos = templateFile.find(findProps);
+        if (findPos != string::npos) {
+            positions.emplace(findPos + findProps.length(), make_pair("asmProps", 0));
+        }
+        if (!buildTemplateDependencySlots(templateFile, positions)) {
+            return false;
+        }
+        // Must be added first so that it is before $(IncludePath) as otherwise there are errors
+        buildTemplateSlots(templateFile, "<AdditionalIncludeDirectories>", "includeDirs", false, positions);
+        // Lib directories depend on the platform of each configuration
+        const string libDirs = "<AdditionalLibraryDirectories>";
+        findPos = templateFile.find(libDirs);
+        while (findPos != string::npos) {
+            findPos += libDirs.length();
+            const string configuration = getTemplateConfiguration(templateFile, findPos);
+            const bool x64 = (configuration.find("|x64") != string::npos);
+            // There are currently no additional ARM64 library directories
+            if (configuration.find("|ARM64") == string::npos) {
+                positions.emplace(findPos, make_pair(x64 ? "libDirs64" : "libDirs32", 0));
+            }
+            findPos = templateFile.find(libDirs, findPos);
+        }
+        buildTemplateSlots(templateFile, "<PreprocessorDefinitions>", "defines", false, positions);
+        // Add any precompiled header settings to each configuration
+        buildTemplateSlots(templateFile, "<ClCompile>", "precompiledHeader", false, positions);
+        buildTemplateSlots(templateFile, "<ForcedIncludeFiles>compat.h;", "forcedIncludes", false, positions);
+        // Existing disabled precompiled headers are removed along with any leading white space
+        const string disabledPCH = "<PrecompiledHeader>NotUsing</PrecompiledHeader>";
+        findPos = templateFile.find(disabledPCH);
+        while (findPos != string::npos) {
+            const uint startPos = templateFile.find_last_not_of(g_whiteSpace, findPos - 1) + 1;
+            positions.emplace(
+                startPos, make_pair("precompiledHeaderDisabled", findPos + disabledPCH.length() - startPos));
+            findPos = templateFile.find(disabledPCH, findPos + disabledPCH.length());
+        }
+    } else if ((resourceID == TEMPLATE_FILTERS_ID) || (resourceID == TEMPLATE_PROG_FILTERS_ID)) {
+        buildTemplateSlots(templateFile, "template_in", "template_in", true, positions);
+        buildTemplateSlots(templateFile, "template_shin", "template_shin", true, positions);
+        // After the last </ItemGroup> add the item groups for each of the source types
+        const string endTag = "</ItemGroup>";
+        uint findPos = templateFile.rfind(endTag);
+        positions.emplace(findPos + endTag.length(), make_pair("filterSources", 0));
+        // Add any additional filters to the end of the first item group
+        findPos = templateFile.find(endTag);
+        findPos = templateFile.find_last_not_of(g_whiteSpace, findPos - 1) +
+            1; // handle potential differences in line endings
+        positions.emplace(findPos, make_pair("filters", 0));
+    } else if (resourceID == TEMPLATE_SLN_ID) {
+        // Projects are added before the first project in the template
+        positions.emplace(templateFile.find("Project") - 2, make_pair("projects", 0));
+        buildTemplateSlots(templateFile, "GlobalSection(ProjectConfigurationPlatforms) = postSolution",
+            "configurations", false, positions);
+        buildTemplateSlots(templateFile, "GlobalSection(NestedProjects) = preSolution", "nested", false, positions);
+    } else {
+        const string tags[] = {"template_in", "template_program", "template_outdir"};
+        for (const auto& i : tags) {
+            buildTemplateSlots(templateFile, i, i, true, positions);
+        }
     }
 
-    // Change all occurrences of template_rootdir with configured output directory
-    string rootDir = m_configHelper.m_rootDirectory;
-    m_configHelper.makeFileProjectRelative(rootDir, rootDir);
-    replace(rootDir.begin(), rootDir.end(), '/', '\\');
-    const string rootSearchTag = "template_rootdir";
-    findPos = projectTemplate.find(rootSearchTag);
+    // Split the template into segments at each slot
+    vector<TemplateSegment>& segments = m_templates[resourceID];
+    segments.reserve(positions.size() + 1);
+    uint startPos = 0;
+    for (const auto& i : positions) {
+        segments.push_back({templateFile.substr(startPos, i.first - startPos), i.second.first,
+            templateFile.substr(i.first, i.second.second)});
+        startPos = i.first + i.second.second;
+    }
+    segments.push_back({templateFile.substr(startPos), "", ""});
+    return true;
+}
+
+void ProjectGenerator::buildTemplateSlots(const string& templateFile, const string& search, const string& slot,
+    const bool replace, multimap<uint, pair<string, uint>>& positions)
+{
+    uint findPos = templateFile.find(search);
     while (findPos != string::npos) {
-        // Replace
-        projectTemplate.replace(findPos, rootSearchTag.length(), rootDir);
+        if (replace) {
+            positions.emplace(findPos, make_pair(slot, search.length()));
+        } else {
+            positions.emplace(findPos + search.length(), make_pair(slot, 0));
+        }
         // Get next
-        findPos = projectTemplate.find(rootSearchTag, findPos + 1);
+        findPos = templateFile.find(search, findPos + search.length());
     }
+}
 
-    // Change all occurrences of template_winver
-    uint major, minor;
-    if (!m_configHelper.getMinWindowsVersion(major, minor)) {
-        outputWarning("Could not detect a supported Windows version. Defaults of WinXP will be used instead.");
+bool ProjectGenerator::buildTemplateDependencySlots(
+    const string& templateFile, multimap<uint, pair<string, uint>>& positions)
+{
+    // Add to Additional Dependencies
+    const string search = "%(AdditionalDependencies)";
+    uint findPos = templateFile.find(search);
+    while (findPos != string::npos) {
+        const string configuration = getTemplateConfiguration(templateFile, findPos);
+        if (configuration.empty()) {
+            outputError("Failed finding configuration of %(AdditionalDependencies) in template.");
+            return false;
+        }
+        const uint linkPos = templateFile.rfind("<Link>", findPos);
+        const uint libPos = templateFile.rfind("<Lib>", findPos);
+        const bool link = (linkPos != string::npos) && ((libPos == string::npos) || (linkPos > libPos));
+        const uint debugRelease = (configuration.find("Debug") == 0) ? 0 : 1;
+        // Any profile guided optimisation or instruction set configurations use the same dependencies as ReleaseDLL
+        const bool dll = (configuration.find("DLL") != string::npos) || (configuration.find("PG") != string::npos) ||
+            (configuration.find("AVX") != string::npos);
+        // Static libs don't link in ffmpeg inter-dependencies
+        uint ffmpegIndex = 4;
+        uint addIndex = debugRelease;
+        if (link) {
+            ffmpegIndex = debugRelease + (dll ? 2 : 0);
+            if (dll && (configuration.find("StaticDeps") == string::npos)) {
+                // Use DLL libs
+                addIndex += 2;
+            }
+        }
+        const uint win = (configuration.find("WinRT") != string::npos) ? 1 : 0;
+        positions.emplace(
+            findPos, make_pair("dependencies" + to_string(ffmpegIndex) + to_string(addIndex) + to_string(win), 0));
+        // Get next
+        findPos = templateFile.find(search, findPos + search.length());
+    }
+    return true;
+}
+
+string ProjectGenerator::getTemplateConfiguration(const string& templateFile, const uint position)
+{
+    const string condition = "'$(Configuration)|$(Platform)'=='";
+    uint findPos = templateFile.rfind(condition, position);
+    if (findPos == string::npos) {
+        return "";
+    }
+    findPos += condition.length();
+    return templateFile.substr(findPos, templateFile.find('\'', findPos) - findPos);
+}
+
+bool ProjectGenerator::isConfigurationEnabled(const string& configuration, const bool program) const
+{
+    const uint split = configuration.find('|');
+    const string platform = configuration.substr(split + 1);
+    const vector<string>& platforms = m_configHelper.m_platforms;
+    if (!platforms.empty() &&
+        (find(platforms.begin(), platforms.end(), (platform == "x86") ? "Win32" : platform) == platforms.end())) {
+        return false;
+    }
+    const vector<string>& configurations = m_configHelper.m_configurations;
+    if (configurations.empty()) {
+        return true;
+    }
+    const string name = configuration.substr(0, split);
+    for (const auto& i : configurations) {
+        string mapped = i;
+        if (program) {
+            // Programs build the WinRT and static deps solution configurations using the matching base configuration
+            findAndReplace(mapped, "WinRT", "");
+            findAndReplace(mapped, "StaticDeps", "");
+        }
+        if (mapped == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ProjectGenerator::outputTemplate(const int resourceID, const TemplateSlots& slots, string& retOutput)
+{
+    if (!buildTemplate(resourceID)) {
+        return false;
+    }
+    const vector<TemplateSegment>& segments = m_templates[resourceID];
+
+    // Find the value of each slot and the total output size
+    vector<const string*> values;
+    values.reserve(segments.size());
+    map<string, uint> slotCounts;
+    uint size = 0;
+    for (const auto& i : segments) {
+        const string* value = &i.slotDefault;
+        const auto slot = slots.find(i.slot);
+        if ((slot != slots.end()) && !slot->second.empty()) {
+            uint& count = slotCounts[i.slot];
+            value = &slot->second[count % slot->second.size()];
+            ++count;
+        }
+        values.push_back(value);
+        size += i.text.length() + value->length();
+    }
+
+    // Output all segments
+    retOutput.clear();
+    retOutput.reserve(size);
+    for (uint i = 0; i < segments.size(); i++) {
+        retOutput += segments[i].text;
+        retOutput += *values[i];
+    }
+    return true;
+}
+
+void ProjectGenerator::outputTemplateTags(TemplateSlots& slots) const
+{
+    // Change all occurrences of template_in with project name
+    slots["template_in"].push_back(m_projectName);
+
+    // Change all occurrences of template_shin with short project name
+    slots["template_shin"].push_back(m_projectName.substr(3)); // The full name minus the lib prefix
+
+    // Change all occurrences of template_platform with specified project toolchain
+    string toolchain = "<PlatformToolset Condition=\"'$(VisualStudioVersion)'=='12.0'\">v120</PlatformToolset>\r\n\
+    <PlatformToolset Condition=\"'$(VisualStudioVersion)'=='14.0'\">v140</PlatformToolset>\r\n\
+    <PlatformToolset Condition=\"'$(VisualStudioVersion)'=='15.0'\">v141</PlatformToolset>\r\n\
+    <PlatformToolset Condition=\"'$(VisualStudioVersion)'=='16.0'\">v142</PlatformToolset>";
+    if (m_configHelper.m_toolchain.compare("clang-cl") == 0) {
+        // The clang toolset is only available from VS2019 onwards and allows for inline asm to be used
+        toolchain = "<PlatformToolset>ClangCL</PlatformToolset>";
+    } else if (m_configHelper.m_toolchain.compare("msvc") != 0) {
+        toolchain +=
+            "\r\n    <PlatformToolset Condition=\"'$(ICPP_COMPILER13)'!=''\">Intel C++ Compiler XE 13.0</PlatformToolset>\r\n\
+    <PlatformToolset Condition=\"'$(ICPP_COMPILER14)'!=''\">Intel C++ Compiler XE 14.0</PlatformToolset>\r\n\
+    <PlatformToolset Condition=\"'$(ICPP_COMPILER15)'!=''\">Intel C++ Compiler XE 15.0</PlatformToolset>\r\n\
+    <PlatformToolset Condition=\"'$(ICPP_COMPILER16)'!=''\">Intel C++ Compiler 16.0</PlatformToolset>\r\n\
+    <PlatformToolset Condition=\"'$(ICPP_COMPILER17)'!=''\">Intel C++ Compiler 17.0</PlatformToolset>\r\n\
+    <PlatformToolset Condition=\"'$(ICPP_COMPILER18)'!=''\">Intel C++ Compiler 18.0</PlatformToolset>\r\n\
+    <PlatformToolset Condition=\"'$(ICPP_COMPILER19)'!=''\">Intel C++ Compiler 19.0</PlatformToolset>";
+    }
+
+    slots["template_platform"].push_back(toolchain);
+
+    // Set the project key
+    map<string, string> keys;
+    buildProjectGUIDs(keys);
+    const auto key = keys.find(m_projectName);
+    if (key != keys.end()) {
+        slots["template_guid"].push_back(key->second);
+    }
+
+    // Change all occurrences of template_outdir with configured output directory
+    string outDir = m_configHelper.m_outDirectory;
+    replace(outDir.begin(), outDir.end(), '/', '\\');
+    if (outDir.at(0) == '.') {
+        outDir = "$(ProjectDir)" + outDir; // Make any relative paths based on project dir
+    }
+    slots["template_outdir"].push_back(outDir);
+
+    // Change all occurrences of template_rootdir with configured output directory
+    string rootDir = m_configHelper.m_rootDirectory;
+    m_configHelper.makeFileProjectRelative(rootDir, rootDir);
+    replace(rootDir.begin(), rootDir.end(), '/', '\\');
+    slots["template_rootdir"].push_back(rootDir);
+
+    // Change all occurrences of template_winver
+    uint major, minor;
+    if (!m_configHelper.getMinWindowsVersion(major, minor)) {
+        outputWarning("Could not detect a supported Windows version. Defaults of WinXP will be used instead.");
         major = 5;
         minor = 1;
     }
@@ -796,22 +1363,8 @@ void ProjectGenerator::outputTemplateTags(string& projectTemplate, string& filte
     } else {
         subsystemVer64 = subsystemVer32;
     }
-    const string winver32Tag = "template_winver32";
-    findPos = projectTemplate.find(winver32Tag);
-    while (findPos != string::npos) {
-        // Replace
-        projectTemplate.replace(findPos, winver32Tag.length(), subsystemVer32);
-        // Get next
-        findPos = projectTemplate.find(winver32Tag, findPos + 1);
-    }
-    const string winver64Tag = "template_winver64";
-    findPos = projectTemplate.find(winver64Tag);
-    while (findPos != string::npos) {
-        // Replace
-        projectTemplate.replace(findPos, winver64Tag.length(), subsystemVer64);
-        // Get next
-        findPos = projectTemplate.find(winver64Tag, findPos + 1);
-    }
+    slots["template_winver32"].push_back(subsystemVer32);
+    slots["template_winver64"].push_back(subsystemVer64);
 
     // Change all occurrences of template_winnt
     string winNtVer, winNtVer32 = "0x";
@@ -830,27 +1383,37 @@ void ProjectGenerator::outputTemplateTags(string& projectTemplate, string& filte
     } else {
         winNtVer64 = winNtVer32;
     }
-    const string winnt32Tag = "template_winnt32";
-    findPos = projectTemplate.find(winnt32Tag);
-    while (findPos != string::npos) {
-        // Replace
-        projectTemplate.replace(findPos, winnt32Tag.length(), winNtVer32);
-        // Get next
-        findPos = projectTemplate.find(winnt32Tag, findPos + 1);
+    slots["template_winnt32"].push_back(winNtVer32);
+    slots["template_winnt64"].push_back(winNtVer64);
+}
+
+void ProjectGenerator::getBuildConfigurations(
+    const bool staticConfigs, const bool sharedConfigs, StaticList& retConfigs) const
+{
+    const bool winRT = m_configHelper.isConfigOptionEnabled("WINRT") || m_configHelper.isConfigOptionEnabled("UWP");
+    if (staticConfigs) {
+        retConfigs.insert(retConfigs.end(), {"Release", "Debug"});
+        if (winRT) {
+            retConfigs.insert(retConfigs.end(), {"ReleaseWinRT", "DebugWinRT"});
+        }
     }
-    const string winnt64Tag = "template_winnt64";
-    findPos = projectTemplate.find(winnt64Tag);
-    while (findPos != string::npos) {
-        // Replace
-        projectTemplate.replace(findPos, winnt64Tag.length(), winNtVer64);
-        // Get next
-        findPos = projectTemplate.find(winnt64Tag, findPos + 1);
+    if (sharedConfigs) {
+        retConfigs.insert(retConfigs.end(), {"ReleaseDLL", "ReleaseDLLStaticDeps", "DebugDLL"});
+        if (winRT) {
+            retConfigs.insert(retConfigs.end(), {"ReleaseDLLWinRT", "ReleaseDLLWinRTStaticDeps", "DebugDLLWinRT"});
+        }
+        if (m_configHelper.m_usePGO) {
+            retConfigs.insert(retConfigs.end(), {"ReleasePGInstrument", "ReleasePGOptimize"});
+        }
+        for (const auto& i : m_configHelper.m_isaVariants) {
+            retConfigs.push_back("Release" + i);
+        }
     }
 }
 
 void ProjectGenerator::outputSourceFileType(StaticList& fileList, const string& type, const string& filterType,
-    string& projectTemplate, string& filterTemplate, StaticList& foundObjects, set<string>& foundFilters,
-    bool checkExisting, bool staticOnly, bool sharedOnly) const
+    string& projectSources, string& filterSources, StaticList& foundObjects, set<string>& foundFilters,
+    bool checkExisting, bool staticOnly, bool sharedOnly, bool excluded) const
 {
     // Declare constant strings used in output files
     const string itemGroup = "\r\n  <ItemGroup>";
@@ -865,10 +1428,12 @@ void ProjectGenerator::outputSourceFileType(StaticList& fileList, const string&
     const string source = filterType + " Files";
     const string filterEnd = "</Filter>";
     const string excludeConfig = "\r\n      <ExcludedFromBuild Condition=\"'$(Configuration)'=='";
-    const string buildConfigsStatic[] = {"Release", "Debug", "ReleaseWinRT", "DebugWinRT"};
-    const string buildConfigsShared[] = {"ReleaseDLL", "ReleaseDLLStaticDeps", "DebugDLL", "ReleaseDLLWinRT",
-        "ReleaseDLLWinRTStaticDeps", "DebugDLLWinRT"};
+    StaticList buildConfigsStatic;
+    StaticList buildConfigsShared;
+    getBuildConfigurations(true, false, buildConfigsStatic);
+    getBuildConfigurations(false, true, buildConfigsShared);
     const string excludeConfigEnd = "'\">true</ExcludedFromBuild>";
+    const string exclude = "\r\n      <ExcludedFromBuild>true</ExcludedFromBuild>";
 
     if (fileList.size() > 0) {
         string typeFiles = itemGroup;
@@ -887,16 +1452,10 @@ void ProjectGenerator::outputSourceFileType(StaticList& fileList, const string&
             typeFilesTemp += file;
             typeFilesFiltTemp += file;
 
-            // Get object name without path or extension
-            uint pos = i.rfind('/') + 1;
-            string objectName = i.substr(pos);
-            uint pos2 = objectName.rfind('.');
-            objectName.resize(pos2);
-
             // Add the filters Filter
             string sourceDir;
             m_configHelper.makeFileProjectRelative(m_configHelper.m_rootDirectory, sourceDir);
-            pos = i.rfind(sourceDir);
+            uint pos = i.rfind(sourceDir);
             pos = (pos == string::npos) ? 0 : pos + sourceDir.length();
             typeFilesFiltTemp += includeClose;
             typeFilesFiltTemp += filterSource;
@@ -910,38 +1469,44 @@ void ProjectGenerator::outputSourceFileType(StaticList& fileList, const string&
             typeFilesFiltTemp += filterEnd;
             typeFilesFiltTemp += typeIncludeEnd;
 
+            // Check if this file is built as part of a unity build file instead
+            if (excluded) {
+                typeFilesTemp += includeClose;
+                typeFilesTemp += exclude;
+                typeFilesTemp += typeIncludeEnd;
+                // Add to output
+                typeFiles += typeFilesTemp;
+                typeFilesFilt += typeFilesFiltTemp;
+                continue;
+            }
+
             // Check if this file should be disabled under certain configurations
             bool closed = false;
             if (staticOnly || sharedOnly) {
                 typeFilesTemp += includeClose;
                 closed = true;
-                const string* buildConfig = nullptr;
-                uint configs = 0;
-                if (staticOnly) {
-                    buildConfig = buildConfigsShared;
-                    configs = sizeof(buildConfigsShared) / sizeof(buildConfigsShared[0]);
-                } else {
-                    buildConfig = buildConfigsStatic;
-                    configs = sizeof(buildConfigsStatic) / sizeof(buildConfigsStatic[0]);
-                }
-                if (!m_configHelper.isConfigOptionEnabled("WINRT") && !m_configHelper.isConfigOptionEnabled("UWP")) {
-                    configs /= 2;
-                }
-                for (uint j = 0; j < configs; j++) {
+                // Static only files are excluded from every dll configuration and shared only from every static one
+                for (const auto& j : staticOnly ? buildConfigsShared : buildConfigsStatic) {
                     typeFilesTemp += excludeConfig;
-                    typeFilesTemp += buildConfig[j];
+                    typeFilesTemp += j;
                     typeFilesTemp += excludeConfigEnd;
                 }
             }
 
+            // Add any custom settings for this file
+            const auto settings = m_sourceFileSettings.find(i);
+            if (settings != m_sourceFileSettings.end()) {
+                if (!closed) {
+                    typeFilesTemp += includeClose;
+                    closed = true;
+                }
+                typeFilesTemp += settings->second;
+            }
+
             // Several input source files have the same name so we need to explicitly specify an output object file
             // otherwise they will clash
-            if (checkExisting && (find(foundObjects.begin(), foundObjects.end(), objectName) != foundObjects.end())) {
-                objectName = i.substr(pos);
-                replace(objectName.begin(), objectName.end(), '/', '_');
-                // Replace the extension with obj
-                pos2 = objectName.rfind('.');
-                objectName.resize(pos2);
+            string objectName;
+            if (getSourceObjectName(i, checkExisting, foundObjects, objectName)) {
                 if (!closed) {
                     typeFilesTemp += includeClose;
                 }
@@ -952,7 +1517,6 @@ void ProjectGenerator::outputSourceFileType(StaticList& fileList, const string&
                 // Add to temp list of stored objects
                 tempObjects.emplace_back(typeFilesTemp, typeFilesFiltTemp);
             } else {
-                foundObjects.push_back(objectName);
                 // Close the current item
                 if (!closed) {
                     typeFilesTemp += includeEnd;
@@ -976,24 +1540,52 @@ void ProjectGenerator::outputSourceFileType(StaticList& fileList, const string&
         typeFiles += itemGroupEnd;
         typeFilesFilt += itemGroupEnd;
 
-        // After </ItemGroup> add the item groups for each of the include types
-        string endTag =
-            "</ItemGroup>"; // Uses independent string to sItemGroupEnd to avoid line ending errors due to \r\n
-        uint findPos = projectTemplate.rfind(endTag);
-        findPos += endTag.length();
-        uint findPosFilt = filterTemplate.rfind(endTag);
-        findPosFilt += endTag.length();
+        // Add to output after any previous item groups
+        projectSources += typeFiles;
+        filterSources += typeFilesFilt;
+    }
+}
+
+bool ProjectGenerator::getSourceObjectName(
+    const string& fileName, const bool checkExisting, StaticList& foundObjects, string& retObjectName) const
+{
+    // Get object name without path or extension
+    uint pos = fileName.rfind('/') + 1;
+    retObjectName = fileName.substr(pos);
+    retObjectName.resize(retObjectName.rfind('.'));
+    if (checkExisting && (find(foundObjects.begin(), foundObjects.end(), retObjectName) != foundObjects.end())) {
+        // Use the path relative to the source directory instead
+        string sourceDir;
+        m_configHelper.makeFileProjectRelative(m_configHelper.m_rootDirectory, sourceDir);
+        pos = fileName.rfind(sourceDir);
+        pos = (pos == string::npos) ? 0 : pos + sourceDir.length();
+        retObjectName = fileName.substr(pos);
+        replace(retObjectName.begin(), retObjectName.end(), '/', '_');
+        retObjectName.resize(retObjectName.rfind('.'));
+        return true;
+    }
+    foundObjects.push_back(retObjectName);
+    return false;
+}
 
-        // Insert into output file
-        projectTemplate.insert(findPos, typeFiles);
-        filterTemplate.insert(findPosFilt, typeFilesFilt);
+string ProjectGenerator::getSourceArch(const string& fileName)
+{
+    // Architecture specific files are all found in a sub directory named after the architecture
+    const string archs[] = {"x86", "aarch64"};
+    for (const auto& i : archs) {
+        if (fileName.find('/' + i + '/') != string::npos) {
+            return i;
+        }
     }
+    return "";
 }
 
-void ProjectGenerator::outputSourceFiles(string& projectTemplate, string& filterTemplate)
+bool ProjectGenerator::outputSourceFiles(TemplateSlots& slots)
 {
     set<string> foundFilters;
     StaticList foundObjects;
+    string projectSources;
+    string filterSources;
 
     // Check if there is a resource file
     string resourceFile;
@@ -1001,33 +1593,168 @@ void ProjectGenerator::outputSourceFiles(string& projectTemplate, string& filter
         m_configHelper.makeFileProjectRelative(resourceFile, resourceFile);
         StaticList resources;
         resources.push_back(resourceFile);
-        outputSourceFileType(resources, "ResourceCompile", "Resource", projectTemplate, filterTemplate, foundObjects,
+        outputSourceFileType(resources, "ResourceCompile", "Resource", projectSources, filterSources, foundObjects,
             foundFilters, false, false, true);
     }
 
+    // Exclude any architecture specific files from the platforms that they do not support
+    if (m_configHelper.m_useARM64) {
+        const string excludeX86 = "\r\n      <ExcludedFromBuild Condition=\"'$(Platform)'=='ARM64'\">true</ExcludedFromBuild>";
+        const string excludeARM64 =
+            "\r\n      <ExcludedFromBuild Condition=\"'$(Platform)'!='ARM64'\">true</ExcludedFromBuild>";
+        for (const auto& i : m_includesASM) {
+            m_sourceFileSettings[i] += excludeX86;
+        }
+        const StaticList* sourceFiles[] = {&m_includesC, &m_includesCPP};
+        for (const auto& i : sourceFiles) {
+            for (const auto& j : *i) {
+                const string arch = getSourceArch(j);
+                if (arch == "x86") {
+                    m_sourceFileSettings[j] += excludeX86;
+                } else if (arch == "aarch64") {
+                    m_sourceFileSettings[j] += excludeARM64;
+                }
+            }
+        }
+    }
+
+    // Assembler include directories are relative to the source root directory
+    string rootDir = m_configHelper.m_rootDirectory;
+    m_configHelper.makeFileProjectRelative(rootDir, rootDir);
+    replace(rootDir.begin(), rootDir.end(), '/', '\\');
+
     // Output ASM files in specific item group (must go first as asm does not allow for custom obj filename)
     if (!m_includesASM.empty()) {
         if (m_configHelper.isASMEnabled()) {
-            outputSourceFileType(m_includesASM, (m_configHelper.m_useNASM) ? "NASM" : "YASM", "Source", projectTemplate,
-                filterTemplate, foundObjects, foundFilters, false);
+            // Assemble using a custom build step so that files can be built in parallel
+            const string asmBuild = getASMBuild(rootDir, getLibraryName());
+            for (const auto& i : m_includesASM) {
+                StaticList includes;
+                if (!findASMIncludes(i, includes)) {
+                    return false;
+                }
+                // Only files that use component options depend on the component config file
+                bool components = false;
+                if (!m_configHelper.m_componentConfigs.empty()) {
+                    includes.insert(includes.begin(), i);
+                    for (const auto& j : includes) {
+                        if (!findComponentUsage(j, components)) {
+                            return false;
+                        }
+                        if (components) {
+                            break;
+                        }
+                    }
+                    includes.erase(includes.begin());
+                }
+                string build = asmBuild;
+                if (components) {
+                    build.insert(build.find(" -o "), " -Pconfig_components.asm");
+                }
+                // Track all included files so that only the objects affected by a change are rebuilt (this is a static
+                // approximation as includes behind conditionals or built from macros can't be found)
+                string dependencies = components ? "config.asm;config_components.asm;" : "config.asm;";
+                for (auto& j : includes) {
+                    replace(j.begin(), j.end(), '/', '\\');
+                    dependencies += j + ';';
+                }
+                m_sourceFileSettings[i] += build + "\r\n      <AdditionalInputs>" + dependencies +
+                    "%(AdditionalInputs)</AdditionalInputs>";
+            }
+            outputSourceFileType(m_includesASM, "CustomBuild", "Source", projectSources, filterSources, foundObjects,
+                foundFilters, false);
         } else {
             outputError("Assembly files found in project but assembly is disabled");
         }
     }
 
+    // Output aarch64 GAS files using a custom build step that converts them for the MSVC ARM64 assembler
+    if (!m_includesGAS.empty()) {
+        const string gasBuild = "\r\n\
+      <Command>gas-preprocessor.pl -arch aarch64 -as-type armasm -- armasm64 -nologo -I\"$(ProjectDir).\" \
+-I\"$(ProjectDir)" + rootDir + ".\" -c -o \"$(IntDir)%(Filename).obj\" \"%(FullPath)\"</Command>\r\n\
+      <Message>%(Filename)%(Extension)</Message>\r\n\
+      <AdditionalInputs>$(ProjectDir)config.h</AdditionalInputs>\r\n\
+      <Outputs>$(IntDir)%(Filename).obj</Outputs>\r\n\
+      <ExcludedFromBuild Condition=\"'$(Platform)'!='ARM64'\">true</ExcludedFromBuild>";
+        for (const auto& i : m_includesGAS) {
+            m_sourceFileSettings[i] += gasBuild;
+        }
+        outputSourceFileType(
+            m_includesGAS, "CustomBuild", "Source", projectSources, filterSources, foundObjects, foundFilters, false);
+    }
+
+    // Add any per file compiler settings (must be before unity files are created)
+    if (!m_fileSettings.empty()) {
+        const StaticList* sourceFiles[] = {&m_includesC, &m_includesCPP};
+        for (const auto& i : sourceFiles) {
+            for (const auto& j : *i) {
+                const string settings = getFileSettingsMSVC(j);
+                if (!settings.empty()) {
+                    m_sourceFileSettings[j] += settings;
+                }
+            }
+        }
+    }
+
     // Output C files
-    outputSourceFileType(
-        m_includesC, "ClCompile", "Source", projectTemplate, filterTemplate, foundObjects, foundFilters, true);
+    StaticList unityFiles;
+    StaticList unityIncludes;
+    if (!createUnityFiles(unityFiles, unityIncludes)) {
+        return false;
+    }
+
+    // Only files that use component options include the component config file (must be after unity files are created)
+    if (!m_configHelper.m_componentConfigs.empty()) {
+        const set<string> unitySet(unityIncludes.begin(), unityIncludes.end());
+        const StaticList* sourceFiles[] = {&m_includesC, &m_includesCPP, &unityFiles};
+        for (const auto& i : sourceFiles) {
+            for (const auto& j : *i) {
+                if (unitySet.find(j) != unitySet.end()) {
+                    continue;
+                }
+                bool components;
+                if (!findComponentUsage(j, components)) {
+                    return false;
+                }
+                if (components) {
+                    // Must be after any precompiled header as anything before it is discarded
+                    m_sourceFileSettings[j] +=
+                        "\r\n      <ForcedIncludeFiles>%(ForcedIncludeFiles);config_components.h</ForcedIncludeFiles>";
+                }
+            }
+        }
+    }
+    if (!unityIncludes.empty()) {
+        const set<string> unitySet(unityIncludes.begin(), unityIncludes.end());
+        StaticList includesC;
+        for (const auto& i : m_includesC) {
+            if (unitySet.find(i) == unitySet.end()) {
+                includesC.push_back(i);
+            }
+        }
+        outputSourceFileType(
+            includesC, "ClCompile", "Source", projectSources, filterSources, foundObjects, foundFilters, true);
+
+        // Output unity build files followed by the files that they contain
+        outputSourceFileType(
+            unityFiles, "ClCompile", "Source", projectSources, filterSources, foundObjects, foundFilters, true);
+        outputSourceFileType(unityIncludes, "ClCompile", "Source", projectSources, filterSources, foundObjects,
+            foundFilters, false, false, false, true);
+    } else {
+        outputSourceFileType(
+            m_includesC, "ClCompile", "Source", projectSources, filterSources, foundObjects, foundFilters, true);
+    }
 
     // Output C++ files
     outputSourceFileType(
-        m_includesCPP, "ClCompile", "Source", projectTemplate, filterTemplate, foundObjects, foundFilters, true);
+        m_includesCPP, "ClCompile", "Source", projectSources, filterSources, foundObjects, foundFilters, true);
 
     // Output CUDA files
     if (!m_includesCU.empty()) {
         if (m_configHelper.isCUDAEnabled()) {
             // outputSourceFileType(
-            //    m_includesCU, "CudaCompile", "Source", projectTemplate, filterTemplate, foundObjects, foundFilters,
+            //    m_includesCU, "CudaCompile", "Source", projectSources, filterSources, foundObjects, foundFilters,
             //    true);
             outputError("CUDA files detected in project. CUDA compilation is not currently supported");
         } else {
@@ -1037,7 +1764,9 @@ void ProjectGenerator::outputSourceFiles(string& projectTemplate, string& filter
 
     // Output header files in new item group
     outputSourceFileType(
-        m_includesH, "ClInclude", "Header", projectTemplate, filterTemplate, foundObjects, foundFilters, false);
+        m_includesH, "ClInclude", "Header", projectSources, filterSources, foundObjects, foundFilters, false);
+    slots["sources"].push_back(projectSources);
+    slots["filterSources"].push_back(filterSources);
 
     // Add any additional Filters to filters file
     const string itemGroupEnd = "\r\n  </ItemGroup>";
@@ -1052,10 +1781,6 @@ void ProjectGenerator::outputSourceFiles(string& projectTemplate, string& filter
         "8a4a673d-2aba-4d8d-a18e-dab035e5c446", "0dcfb38d-54ca-4ceb-b383-4662f006eca9",
         "57bf1423-fb68-441f-b5c1-f41e6ae5fa9c"};
 
-    // get start position in file
-    uint findPosFilt = filterTemplate.find("</ItemGroup>");
-    findPosFilt = filterTemplate.find_last_not_of(g_whiteSpace, findPosFilt - 1) +
-        1; // handle potential differences in line endings
     uint currentKey = 0;
     string addFilters;
     for (const auto& i : foundFilters) {
@@ -1066,8 +1791,9 @@ void ProjectGenerator::outputSourceFiles(string& projectTemplate, string& filter
         currentKey++;
         addFilters += filterAddClose;
     }
-    // Add to string
-    filterTemplate.insert(findPosFilt, addFilters);
+    // Add to the end of the first item group
+    slots["filters"].push_back(addFilters);
+    return true;
 }
 
 bool ProjectGenerator::outputProjectExports(const StaticList& includeDirs)
@@ -1118,19 +1844,19 @@ bool ProjectGenerator::outputProjectExports(const StaticList& includeDirs)
         return false;
     }
 
-    // Split each source file into different directories to avoid name clashes
-    map<string, StaticList> directoryObjects;
-    for (const auto& i : m_includesC) {
-        // Several input source files have the same name so we need to explicitly specify an output object file
-        // otherwise they will clash
-        uint pos = i.rfind("../");
-        pos = (pos == string::npos) ? 0 : pos + 3;
-        uint pos2 = i.rfind('/');
-        pos2 = (pos2 == string::npos) ? string::npos : pos2 - pos;
-        string folderName = i.substr(pos, pos2);
-        directoryObjects[folderName].push_back(i);
+    // Find any exports directly from their definitions in the source files
+    ExportMatcher matcher;
+    outputProjectExportsBuildMatcher(exportStrings, matcher);
+    set<string> moduleExports;
+    set<string> moduleDataExports;
+    StaticList unresolvedFiles;
+    if (!outputProjectExportsStatic(matcher, moduleExports, moduleDataExports, unresolvedFiles)) {
+        return false;
     }
-    for (const auto& i : m_includesCPP) {
+
+    // Split each remaining source file into different directories to avoid name clashes
+    map<string, StaticList> directoryObjects;
+    for (const auto& i : unresolvedFiles) {
         // Several input source files have the same name so we need to explicitly specify an output object file
         // otherwise they will clash
         uint pos = i.rfind("../");
@@ -1141,174 +1867,70 @@ bool ProjectGenerator::outputProjectExports(const StaticList& includeDirs)
         directoryObjects[folderName].push_back(i);
     }
 
-    if (!runCompiler(includeDirs, directoryObjects, 0)) {
-        return false;
-    }
-
-    // Loaded in the compiler passed files
-    StaticList filesSBR;
-    StaticList moduleExports;
-    StaticList moduleDataExports;
-    string tempFolder = m_tempDirectory + m_projectName;
-    findFiles(tempFolder + "/*.sbr", filesSBR);
-    for (const auto& i : filesSBR) {
-        string fileSBR;
-        loadFromFile(i, fileSBR, true);
-
-        // Search through file for module exports
-        for (const auto& j : exportStrings) {
-            // SBR files contain data in specif formats
-            // NULL SizeOfID Type Imp NULL ID Name NULL
-            // where:
-            // SizeOfID specifies how many characters are in the ID
-            //  ETX=2
-            //  C=3
-            // Type specifies the type of the entry (function, data, define etc.)
-            //  BEL=typedef
-            //  EOT=data
-            //  SOH=function
-            //  ENQ=pre-processor define
-            // Imp specifies if this is an declaration or a definition
-            //  `=declaration
-            //  @=definition
-            //  STX=static or inline
-            //  NULL=pre-processor
-            // ID is a 2 or 3 character sequence used to uniquely identify the object
-
-            // Check if it is a wild card search
-            findPos = j.find('*');
-            if (findPos != string::npos) {
-                // Strip the wild card (Note: assumes wild card is at the end!)
-                string search = j.substr(0, findPos);
-
-                // Search for all occurrences
-                findPos = fileSBR.find(search);
-                while (findPos != string::npos) {
-                    // Find end of name signalled by NULL character
-                    uint findPos2 = fileSBR.find(static_cast<char>(0x00), findPos + 1);
-                    if (findPos2 == string::npos) {
-                        findPos = findPos2;
-                        break;
-                    }
+    // Fall back to using the compiler for any files that could not be resolved
+    if (!directoryObjects.empty()) {
+        outputInfo("Compiling " + to_string(unresolvedFiles.size()) + " files to find remaining exports");
+        if (!runCompiler(includeDirs, directoryObjects)) {
+            return false;
+        }
 
-                    // Check if this is a define
-                    uint findPos3 = fileSBR.rfind(static_cast<char>(0x00), findPos - 3);
-                    while (fileSBR.at(findPos3 - 1) == static_cast<char>(0x00)) {
-                        // Skip if there was a NULL in ID
-                        --findPos3;
-                    }
-                    uint findPosDiff = findPos - findPos3;
-                    if ((fileSBR.at(findPos3 - 1) == '@') &&
-                        (((findPosDiff == 3) && (fileSBR.at(findPos3 - 3) == static_cast<char>(0x03))) ||
-                            ((findPosDiff == 4) && (fileSBR.at(findPos3 - 3) == 'C')))) {
-                        // Check if this is a data or function name
-                        string foundName = fileSBR.substr(findPos, findPos2 - findPos);
-                        if (fileSBR.at(findPos3 - 2) == static_cast<char>(0x01)) {
-                            // This is a function
-                            if (find(moduleExports.begin(), moduleExports.end(), foundName) == moduleExports.end()) {
-                                moduleExports.push_back(foundName);
-                            }
-                        } else if (fileSBR.at(findPos3 - 2) == static_cast<char>(0x04)) {
-                            // This is data
-                            if (find(moduleDataExports.begin(), moduleDataExports.end(), foundName) ==
-                                moduleDataExports.end()) {
-                                moduleDataExports.push_back(foundName);
-                            }
-                        }
-                    }
+        // Loaded in the compiler passed files
+        StaticList filesSBR;
+        StaticList filesObject;
+        string tempFolder = m_tempDirectory + m_projectName;
+        findFiles(tempFolder + "/*.sbr", filesSBR);
+        findFiles(tempFolder + "/*.o", filesObject);
+        vector<SymbolRecord> records;
+        for (const auto& i : filesSBR) {
+            string fileSBR;
+            loadFromFile(i, fileSBR, true);
+            outputProjectExportsDecodeSBR(fileSBR, records);
+        }
+        for (const auto& i : filesObject) {
+            string fileObject;
+            loadFromFile(i, fileObject, true);
+            outputProjectExportsDecodeObject(fileObject, records);
+        }
 
-                    // Get next
-                    findPos = fileSBR.find(search, findPos2 + 1);
-                }
+        // Search through the found symbols for module exports
+        for (const auto& i : records) {
+            if (!i.definition || !outputProjectExportsMatch(matcher, i.name)) {
+                continue;
+            }
+            if (i.data) {
+                moduleDataExports.insert(i.name);
             } else {
-                findPos = fileSBR.find(j);
-                // Make sure the match is an exact one
-                uint findPos3;
-                while ((findPos != string::npos)) {
-                    if (fileSBR.at(findPos + j.length()) == static_cast<char>(0x00)) {
-                        findPos3 = fileSBR.rfind(static_cast<char>(0x00), findPos - 3);
-                        while (fileSBR.at(findPos3 - 1) == static_cast<char>(0x00)) {
-                            // Skip if there was a NULL in ID
-                            --findPos3;
-                        }
-                        uint findPosDiff = findPos - findPos3;
-                        if ((fileSBR.at(findPos3 - 1) == '@') &&
-                            (((findPosDiff == 3) && (fileSBR.at(findPos3 - 3) == static_cast<char>(0x03))) ||
-                                ((findPosDiff == 4) && (fileSBR.at(findPos3 - 3) == 'C')))) {
-                            break;
-                        }
-                    }
-                    findPos = fileSBR.find(j, findPos + 1);
-                }
-                if (findPos == string::npos) {
-                    continue;
-                }
-                // Check if this is a data or function name
-                if (fileSBR.at(findPos3 - 2) == static_cast<char>(0x01)) {
-                    // This is a function
-                    if (find(moduleExports.begin(), moduleExports.end(), j) == moduleExports.end()) {
-                        moduleExports.push_back(j);
-                    }
-                } else if (fileSBR.at(findPos3 - 2) == static_cast<char>(0x04)) {
-                    // This is data
-                    if (find(moduleDataExports.begin(), moduleDataExports.end(), j) == moduleDataExports.end()) {
-                        moduleDataExports.push_back(j);
-                    }
-                }
+                moduleExports.insert(i.name);
             }
         }
+        // Remove the test sbr and object files
+        deleteFolder(tempFolder);
     }
-    // Remove the test sbr files
-    deleteFolder(tempFolder);
 
     // Check for any exported functions in asm files
+    const string nameChars = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_";
     for (const auto& i : m_includesASM) {
         string fileASM;
         loadFromFile(m_configHelper.m_solutionDirectory + i, fileASM);
 
-        // Search through file for module exports
-        for (const auto& j : exportStrings) {
-            // Check if it is a wild card search
-            findPos = j.find('*');
-            const string invalidChars = ",.(){}[]`'\"+-*/!@#$%^&*<>|;\\= \r\n\t";
-            if (findPos != string::npos) {
-                // Strip the wild card (Note: assumes wild card is at the end!)
-                string search = ' ' + j.substr(0, findPos);
-                // Search for all occurrences
-                findPos = fileASM.find(search);
-                while ((findPos != string::npos) && (findPos > 0)) {
-                    // Find end of name signaled by first non valid character
-                    uint findPos2 = fileASM.find_first_of(invalidChars, findPos + 1);
-                    // Check this is valid function definition
-                    if ((fileASM.at(findPos2) == '(') && (invalidChars.find(fileASM.at(findPos - 1)) == string::npos)) {
-                        string foundName = fileASM.substr(findPos, findPos2 - findPos);
-                        if (find(moduleExports.begin(), moduleExports.end(), foundName) == moduleExports.end()) {
-                            moduleExports.push_back(foundName.substr(1));
-                        }
-                    }
-
-                    // Get next
-                    findPos = fileASM.find(search, findPos2 + 1);
-                }
-            } else {
-                string search = ' ' + j + '(';
-                findPos = fileASM.find(j);
-                // Make sure the match is an exact one
-                if ((findPos != string::npos) && (findPos > 0) &&
-                    (invalidChars.find(fileASM.at(findPos - 1)) == string::npos)) {
-                    // Check this is valid function definition
-                    if (find(moduleExports.begin(), moduleExports.end(), j) == moduleExports.end()) {
-                        moduleExports.push_back(j);
-                    }
+        // Search through file for any names directly followed by parameters
+        findPos = fileASM.find_first_of(nameChars);
+        while (findPos != string::npos) {
+            uint findPos2 = fileASM.find_first_not_of(nameChars, findPos);
+            if (findPos2 == string::npos) {
+                break;
+            }
+            // Check this is valid function definition
+            if ((fileASM.at(findPos2) == '(') && (findPos > 0) && (fileASM.at(findPos - 1) == ' ')) {
+                string foundName = fileASM.substr(findPos, findPos2 - findPos);
+                if (outputProjectExportsMatch(matcher, foundName)) {
+                    moduleExports.insert(foundName);
                 }
             }
+            findPos = fileASM.find_first_of(nameChars, findPos2);
         }
     }
 
-    // Sort the exports
-    sort(moduleExports.begin(), moduleExports.end());
-    sort(moduleDataExports.begin(), moduleDataExports.end());
-
     // Create the export module string
     string moduleFile = "EXPORTS\r\n";
     for (const auto& i : moduleExports) {
@@ -1325,10 +1947,442 @@ bool ProjectGenerator::outputProjectExports(const StaticList& includeDirs)
     return true;
 }
 
-void ProjectGenerator::outputBuildEvents(string& projectTemplate)
+void ProjectGenerator::outputProjectExportsBuildMatcher(const StaticList& exportStrings, ExportMatcher& matcher)
+{
+    matcher.nodes.clear();
+    matcher.nodes.emplace_back();
+    matcher.exact.clear();
+    for (const auto& i : exportStrings) {
+        // Check if it is a wild card search (Note: assumes wild card is at the end!)
+        const uint findPos = i.find('*');
+        if (findPos == string::npos) {
+            matcher.exact.insert(i);
+            continue;
+        }
+        // Add the prefix to the trie
+        uint node = 0;
+        for (uint j = 0; j < findPos; j++) {
+            const auto child = matcher.nodes[node].children.find(i.at(j));
+            if (child != matcher.nodes[node].children.end()) {
+                node = child->second;
+            } else {
+                matcher.nodes.emplace_back();
+                const uint newNode = matcher.nodes.size() - 1;
+                matcher.nodes[node].children[i.at(j)] = newNode;
+                node = newNode;
+            }
+        }
+        matcher.nodes[node].wildcard = true;
+    }
+}
+
+bool ProjectGenerator::outputProjectExportsMatch(const ExportMatcher& matcher, const string& name)
+{
+    if (matcher.exact.find(name) != matcher.exact.end()) {
+        return true;
+    }
+    // Walk the trie until a wild card prefix is found
+    uint node = 0;
+    for (const auto& i : name) {
+        if (matcher.nodes[node].wildcard) {
+            return true;
+        }
+        const auto child = matcher.nodes[node].children.find(i);
+        if (child == matcher.nodes[node].children.end()) {
+            return false;
+        }
+        node = child->second;
+    }
+    return matcher.nodes[node].wildcard;
+}
+
+void ProjectGenerator::outputProjectExportsDecodeSBR(const string& fileSBR, vector<SymbolRecord>& records)
+{
+    // SBR files contain data in specif formats
+    // NULL SizeOfID Type Imp NULL ID Name NULL
+    // where:
+    // SizeOfID specifies how many characters are in the ID
+    //  ETX=2
+    //  C=3
+    // Type specifies the type of the entry (function, data, define etc.)
+    //  BEL=typedef
+    //  EOT=data
+    //  SOH=function
+    //  ENQ=pre-processor define
+    // Imp specifies if this is an declaration or a definition
+    //  `=declaration
+    //  @=definition
+    //  STX=static or inline
+    //  NULL=pre-processor
+    // ID is a 2 or 3 character sequence used to uniquely identify the object
+    const string nameChars = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_";
+    uint findPos = fileSBR.find(static_cast<char>(0x00), 3);
+    while (findPos != string::npos) {
+        // Check for a valid record header before the NULL
+        const char imp = fileSBR.at(findPos - 1);
+        const char size = fileSBR.at(findPos - 3);
+        const uint sizeID = (size == static_cast<char>(0x03)) ? 2 : ((size == 'C') ? 3 : 0);
+        const char type = fileSBR.at(findPos - 2);
+        if ((sizeID != 0) && ((imp == '@') || (imp == '`') || (imp == static_cast<char>(0x02)))) {
+            // Get the name following the ID
+            const uint namePos = findPos + 1 + sizeID;
+            const uint nameEnd = fileSBR.find(static_cast<char>(0x00), namePos);
+            if (nameEnd == string::npos) {
+                break;
+            }
+            if ((nameEnd > namePos) && (fileSBR.find_first_not_of(nameChars, namePos) == nameEnd) &&
+                !isdigit(fileSBR.at(namePos))) {
+                // Only functions and data are needed
+                if ((type == static_cast<char>(0x01)) || (type == static_cast<char>(0x04))) {
+                    records.push_back(
+                        {fileSBR.substr(namePos, nameEnd - namePos), type == static_cast<char>(0x04), imp == '@'});
+                }
+                findPos = fileSBR.find(static_cast<char>(0x00), nameEnd + 1);
+                continue;
+            }
+        }
+        findPos = fileSBR.find(static_cast<char>(0x00), findPos + 1);
+    }
+}
+
+void ProjectGenerator::outputProjectExportsDecodeObject(const string& fileObject, vector<SymbolRecord>& records)
+{
+    // Reads an unsigned value from the file returning 0 if it is out of range
+    bool bigEndian = false;
+    const auto readValue = [&](uint pos, uint size) -> uint {
+        if ((pos + size) > fileObject.length()) {
+            return 0;
+        }
+        uint value = 0;
+        for (uint i = 0; i < size; i++) {
+            const uint byte = static_cast<unsigned char>(fileObject.at(bigEndian ? pos + i : pos + size - 1 - i));
+            value = (value << 8) | byte;
+        }
+        return value;
+    };
+    // Reads a NULL terminated string from the file
+    const auto readString = [&](uint pos, uint maxLength) -> string {
+        if (pos >= fileObject.length()) {
+            return "";
+        }
+        uint end = fileObject.find(static_cast<char>(0x00), pos);
+        end = min<uint>(end, fileObject.length());
+        return fileObject.substr(pos, min<uint>(end - pos, maxLength));
+    };
+
+    if (fileObject.compare(0, 4, "\x7F""ELF") == 0) {
+        // ELF objects contain a symbol table section linked to a string table section
+        const bool is64 = (readValue(4, 1) == 2);
+        bigEndian = (readValue(5, 1) == 2);
+        const uint sectionOffset = is64 ? readValue(0x28, 8) : readValue(0x20, 4);
+        const uint sectionSize = is64 ? readValue(0x3A, 2) : readValue(0x2E, 2);
+        const uint numSections = is64 ? readValue(0x3C, 2) : readValue(0x30, 2);
+        for (uint i = 0; i < numSections; i++) {
+            const uint section = sectionOffset + (i * sectionSize);
+            if (readValue(section + 4, 4) != 2) {
+                // Not a SHT_SYMTAB section
+                continue;
+            }
+            const uint symbolOffset = is64 ? readValue(section + 0x18, 8) : readValue(section + 0x10, 4);
+            const uint symbolsSize = is64 ? readValue(section + 0x20, 8) : readValue(section + 0x14, 4);
+            const uint stringSection = sectionOffset + (readValue(section + (is64 ? 0x28 : 0x18), 4) * sectionSize);
+            const uint stringOffset = is64 ? readValue(stringSection + 0x18, 8) : readValue(stringSection + 0x10, 4);
+            const uint stringSize = is64 ? readValue(stringSection + 0x20, 8) : readValue(stringSection + 0x14, 4);
+            const uint symbolSize = is64 ? 24 : 16;
+            for (uint j = symbolOffset; (j + symbolSize) <= min<uint>(symbolOffset + symbolsSize, fileObject.length());
+                 j += symbolSize) {
+                const uint info = is64 ? readValue(j + 4, 1) : readValue(j + 12, 1);
+                const uint other = is64 ? readValue(j + 5, 1) : readValue(j + 13, 1);
+                const uint sectionIndex = is64 ? readValue(j + 6, 2) : readValue(j + 14, 2);
+                const uint binding = info >> 4;
+                const uint type = info & 0xF;
+                // Only visible global (or weak) functions and objects that are defined in this file are needed
+                if (((binding != 1) && (binding != 2)) || ((type != 1) && (type != 2)) || (sectionIndex == 0) ||
+                    ((other & 0x3) == 1) || ((other & 0x3) == 2)) {
+                    continue;
+                }
+                const uint nameOffset = readValue(j, 4);
+                if (nameOffset >= stringSize) {
+                    continue;
+                }
+                const string name = readString(stringOffset + nameOffset, stringSize - nameOffset);
+                if (!name.empty()) {
+                    records.push_back({name, type == 1, true});
+                }
+            }
+        }
+    } else if (fileObject.length() >= 20) {
+        // COFF objects start with the machine type and contain a single symbol table followed by a string table
+        const uint machine = readValue(0, 2);
+        if ((machine != 0x14C) && (machine != 0x8664) && (machine != 0xAA64) && (machine != 0x1C4)) {
+            return;
+        }
+        const uint symbolOffset = readValue(8, 4);
+        const uint numSymbols = readValue(12, 4);
+        const uint sectionOffset = 20 + readValue(16, 2);
+        const uint stringOffset = symbolOffset + (numSymbols * 18);
+        for (uint i = 0; i < numSymbols; i++) {
+            const uint symbol = symbolOffset + (i * 18);
+            if ((symbol + 18) > fileObject.length()) {
+                break;
+            }
+            const auto sectionNumber = static_cast<short>(readValue(symbol + 12, 2));
+            const uint type = readValue(symbol + 14, 2);
+            const uint storageClass = readValue(symbol + 16, 1);
+            const uint numAux = readValue(symbol + 17, 1);
+            const uint value = readValue(symbol + 8, 4);
+            i += numAux;
+            // Only external symbols that are defined (or common) in this file are needed
+            if ((storageClass != 2) || ((sectionNumber <= 0) && ((sectionNumber != 0) || (value == 0)))) {
+                continue;
+            }
+            string name;
+            if (readValue(symbol, 4) == 0) {
+                name = readString(stringOffset + readValue(symbol + 4, 4), string::npos);
+            } else {
+                name = readString(symbol, 8);
+            }
+            // 32bit x86 symbols are decorated with a leading underscore
+            if ((machine == 0x14C) && (name.length() > 1) && (name.at(0) == '_')) {
+                name.erase(0, 1);
+            }
+            // Functions are either marked as such or are found in a section containing code
+            const bool function = ((type >> 4) == 2) ||
+                ((sectionNumber > 0) && ((readValue(sectionOffset + ((sectionNumber - 1) * 40) + 36, 4) & 0x20) != 0));
+            if (!name.empty()) {
+                records.push_back({name, !function, true});
+            }
+        }
+    }
+}
+
+bool ProjectGenerator::outputProjectExportsStatic(const ExportMatcher& matcher, set<string>& moduleExports,
+    set<string>& moduleDataExports, StaticList& unresolvedFiles)
+{
+    StaticList sourceFiles = m_includesC;
+    sourceFiles.insert(sourceFiles.end(), m_includesCPP.begin(), m_includesCPP.end());
+    for (const auto& i : sourceFiles) {
+        string fileName;
+        m_configHelper.makeFileGeneratorRelative(i, fileName);
+        string file;
+        if (!loadFromFile(fileName, file)) {
+            return false;
+        }
+        set<string> fileExports;
+        set<string> fileDataExports;
+        if (!outputProjectExportsFindDefinitions(file, matcher, fileExports, fileDataExports)) {
+            // The definitions in this file depend on values that can only be determined by the compiler
+            unresolvedFiles.push_back(i);
+            continue;
+        }
+        moduleExports.insert(fileExports.begin(), fileExports.end());
+        moduleDataExports.insert(fileDataExports.begin(), fileDataExports.end());
+    }
+    return true;
+}
+
+bool ProjectGenerator::outputProjectExportsFindDefinitions(const string& file, const ExportMatcher& matcher,
+    set<string>& moduleExports, set<string>& moduleDataExports)
+{
+    // Remove comments and the contents of any strings so that they can't be mistaken for code
+    // Include file names are kept so that any included source files can still be detected
+    string code;
+    removeComments(file, code);
+
+    // Conditional states are 0=disabled, 1=enabled, 2=unknown
+    struct Conditional
+    {
+        uint state;
+        uint taken;
+    };
+    vector<Conditional> conditionals;
+    const string nameChars = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_";
+    uint depth = 0;
+    uint parenDepth = 0;
+    bool macroCall = false;
+    string declaration;
+    bool lineStart = true;
+    uint pos = 0;
+    while (pos < code.length()) {
+        const char c = code.at(pos);
+        if (c == '\n') {
+            lineStart = true;
+            ++pos;
+            continue;
+        }
+        if (lineStart && (g_whiteSpace.find(c) != string::npos)) {
+            ++pos;
+            continue;
+        }
+        if (lineStart && (c == '#')) {
+            // Get the pre-processor directive and its value
+            uint end = code.find('\n', pos);
+            end = (end == string::npos) ? code.length() : end;
+            uint dirStart = code.find_first_not_of(g_whiteSpace, pos + 1);
+            uint dirEnd = code.find_first_not_of(nameChars, dirStart);
+            dirEnd = (dirEnd > end) ? end : dirEnd;
+            const string directive = (dirStart < end) ? code.substr(dirStart, dirEnd - dirStart) : "";
+            string value = code.substr(dirEnd, end - dirEnd);
+            pos = end;
+            uint state = 2;
+            if ((directive == "if") || (directive == "elif")) {
+                outputProgramDCEsResolveDefine(value);
+                state = (value == "1") ? 1 : ((value == "0") ? 0 : 2);
+            } else if ((directive == "ifdef") || (directive == "ifndef")) {
+                // All config values are always defined
+                removeWhiteSpace(value);
+                if (m_configHelper.isConfigOptionValidPrefixed(value)) {
+                    state = (directive == "ifdef") ? 1 : 0;
+                }
+            }
+            if ((directive == "if") || (directive == "ifdef") || (directive == "ifndef")) {
+                conditionals.push_back({state, state});
+            } else if ((directive == "elif") || (directive == "else")) {
+                if (conditionals.empty()) {
+                    return false;
+                }
+                Conditional& back = conditionals.back();
+                if (back.taken == 1) {
+                    back.state = 0;
+                } else if (directive == "else") {
+                    back.state = (back.taken == 0) ? 1 : 2;
+                } else {
+                    back.state = (back.taken == 0) ? state : ((state == 0) ? 0 : 2);
+                }
+                back.taken = (back.state == 1) ? 1 : max(back.taken, back.state);
+            } else if (directive == "endif") {
+                if (conditionals.empty()) {
+                    return false;
+                }
+                conditionals.pop_back();
+            } else if ((directive == "define") && (value.find("##") != string::npos)) {
+                // Check for any exports being created by macro expansion
+                uint findPos = value.find_first_of(nameChars);
+                while (findPos != string::npos) {
+                    const uint findPos2 = value.find_first_not_of(nameChars, findPos);
+                    if (outputProjectExportsMatch(matcher, value.substr(findPos, findPos2 - findPos))) {
+                        return false;
+                    }
+                    findPos = (findPos2 != string::npos) ? value.find_first_of(nameChars, findPos2) : findPos2;
+                }
+            } else if ((directive == "include") &&
+                ((value.find(".c\"") != string::npos) || (value.find(".c>") != string::npos))) {
+                // Included source files may contain additional exports so the compiler must be used instead
+                return false;
+            }
+            continue;
+        }
+        lineStart = false;
+
+        if (c == '{') {
+            ++depth;
+        } else if (c == '}') {
+            depth = (depth > 0) ? depth - 1 : 0;
+            if (depth == 0) {
+                declaration.clear();
+            }
+        } else if (depth == 0) {
+            if (c == '(') {
+                if (parenDepth == 0) {
+                    // Brackets that directly follow the first name of a declaration are a macro call
+                    istringstream ss(declaration);
+                    const vector<string> tokens{istream_iterator<string>{ss}, istream_iterator<string>{}};
+                    macroCall = (tokens.size() <= 1);
+                }
+                ++parenDepth;
+            } else if (c == ')') {
+                parenDepth = (parenDepth > 0) ? parenDepth - 1 : 0;
+            } else if (c == ';') {
+                declaration.clear();
+            } else if ((parenDepth > 0) && macroCall && (nameChars.find(c) != string::npos) && !isdigit(c)) {
+                uint end = code.find_first_not_of(nameChars, pos);
+                end = (end == string::npos) ? code.length() : end;
+                const string name = code.substr(pos, end - pos);
+                if (outputProjectExportsMatch(matcher, name)) {
+                    // The macro may create a definition from an export name so the compiler must be used instead
+                    return false;
+                }
+                declaration += name;
+                pos = end;
+                continue;
+            } else if ((parenDepth == 0) && (nameChars.find(c) != string::npos) && !isdigit(c)) {
+                uint end = code.find_first_not_of(nameChars, pos);
+                end = (end == string::npos) ? code.length() : end;
+                const string name = code.substr(pos, end - pos);
+                if (name == "extern") {
+                    // Definitions inside an extern "C" block are not at file scope depth
+                    uint findPos = code.find_first_not_of(g_whiteSpace, end);
+                    if ((findPos != string::npos) && (code.at(findPos) == '"')) {
+                        findPos = code.find('"', findPos + 1);
+                        findPos = (findPos != string::npos) ? code.find_first_not_of(g_whiteSpace, findPos + 1) :
+                                                              findPos;
+                        if ((findPos != string::npos) && (code.at(findPos) == '{')) {
+                            return false;
+                        }
+                    }
+                }
+                // Check if the name matches any of the export strings
+                const bool match = outputProjectExportsMatch(matcher, name);
+                uint next = code.find_first_not_of(g_whiteSpace, end);
+                // Names used within an initializer are not definitions
+                if (match && (next != string::npos) && (declaration.find('=') == string::npos)) {
+                    // Get the state of the current code block
+                    uint state = 1;
+                    for (const auto& i : conditionals) {
+                        state = (i.state == 0) ? 0 : max(state, i.state);
+                    }
+                    // Determine the type of declaration
+                    istringstream ss(declaration);
+                    vector<string> tokens{istream_iterator<string>{ss}, istream_iterator<string>{}};
+                    const bool isStatic = (find(tokens.begin(), tokens.end(), "static") != tokens.end()) ||
+                        (find(tokens.begin(), tokens.end(), "typedef") != tokens.end());
+                    const bool isExtern = (find(tokens.begin(), tokens.end(), "extern") != tokens.end());
+                    bool isFunction = false;
+                    bool isData = false;
+                    if (code.at(next) == '(') {
+                        // Find the end of the parameters and check for a function body
+                        uint count = 1;
+                        uint findPos = next;
+                        while ((count > 0) && ((findPos = code.find_first_of("()", findPos + 1)) != string::npos)) {
+                            count += (code.at(findPos) == '(') ? 1 : -1;
+                        }
+                        findPos = (findPos != string::npos) ? code.find_first_not_of(g_whiteSpace, findPos + 1) :
+                                                              findPos;
+                        isFunction = (findPos != string::npos) && (code.at(findPos) == '{');
+                    } else {
+                        // Skip any array sizes and check for a definition
+                        while ((next != string::npos) && (code.at(next) == '[')) {
+                            next = code.find(']', next);
+                            next = (next != string::npos) ? code.find_first_not_of(g_whiteSpace, next + 1) : next;
+                        }
+                        isData = (next != string::npos) &&
+                            ((code.at(next) == '=') || (code.at(next) == ';') || (code.at(next) == ','));
+                    }
+                    if (!isStatic && (isFunction || (isData && !isExtern))) {
+                        if (state == 2) {
+                            // The definition depends on a value that is not currently known
+                            return false;
+                        }
+                        if (state == 1) {
+                            set<string>& exports = (isFunction) ? moduleExports : moduleDataExports;
+                            exports.insert(name);
+                        }
+                    }
+                }
+                declaration += ' ' + name + ' ';
+                pos = end;
+                continue;
+            }
+            declaration += c;
+        }
+        ++pos;
+    }
+    return true;
+}
+
+void ProjectGenerator::outputBuildEvents(TemplateSlots& slots)
 {
     // After </Lib> and </Link> and the post and then pre build events
-    const string libLink[2] = {"</Lib>", "</Link>"};
     const string postbuild = "\r\n    <PostBuildEvent>\r\n\
       <Command>";
     const string postbuildClose = "</Command>\r\n\
@@ -1351,6 +2405,12 @@ del template_rootdirversion.h\r\n\
 if exist template_rootdirconfig.asm (\r\n\
 del template_rootdirconfig.asm\r\n\
 )\r\n\
+if exist template_rootdirconfig_components.h (\r\n\
+del template_rootdirconfig_components.h\r\n\
+)\r\n\
+if exist template_rootdirconfig_components.asm (\r\n\
+del template_rootdirconfig_components.asm\r\n\
+)\r\n\
 if exist template_rootdirlibavutil\\avconfig.h (\r\n\
 del template_rootdirlibavutil\\avconfig.h\r\n\
 )\r\n\
@@ -1406,21 +2466,13 @@ cd $(ProjectDir)\r\n\
         additional += prebuildDir;
     }
     additional += prebuildClose;
+    findAndReplace(additional, "template_rootdir", slots["template_rootdir"].front());
 
-    for (const auto& i : libLink) {
-        uint findPos = projectTemplate.find(i);
-        while (findPos != string::npos) {
-            findPos += i.length();
-            // Add to output
-            projectTemplate.insert(findPos, additional);
-            findPos += additional.length();
-            // Get next
-            findPos = projectTemplate.find(i, findPos + 1);
-        }
-    }
+    // Add to output
+    slots["buildEvents"].push_back(additional);
 }
 
-void ProjectGenerator::outputIncludeDirs(const StaticList& includeDirs, string& projectTemplate)
+void ProjectGenerator::outputIncludeDirs(const StaticList& includeDirs, TemplateSlots& slots)
 {
     if (!includeDirs.empty()) {
         string addInclude;
@@ -1428,21 +2480,12 @@ void ProjectGenerator::outputIncludeDirs(const StaticList& includeDirs, string&
             addInclude += i + ";";
         }
         replace(addInclude.begin(), addInclude.end(), '/', '\\');
-        const string addIncludeDir = "<AdditionalIncludeDirectories>";
-        uint findPos = projectTemplate.find(addIncludeDir);
-        while (findPos != string::npos) {
-            // Add to output
-            findPos += addIncludeDir.length(); // Must be added first so that it is before $(IncludePath) as
-                                               // otherwise there are errors
-            projectTemplate.insert(findPos, addInclude);
-            findPos += addInclude.length();
-            // Get next
-            findPos = projectTemplate.find(addIncludeDir, findPos + 1);
-        }
+        // Add to output
+        slots["includeDirs"].push_back(addInclude);
     }
 }
 
-void ProjectGenerator::outputLibDirs(const StaticList& lib32Dirs, const StaticList& lib64Dirs, string& projectTemplate)
+void ProjectGenerator::outputLibDirs(const StaticList& lib32Dirs, const StaticList& lib64Dirs, TemplateSlots& slots)
 {
     if ((!lib32Dirs.empty()) || (!lib64Dirs.empty())) {
         // Add additional lib includes to include list based on current config
@@ -1455,101 +2498,72 @@ void ProjectGenerator::outputLibDirs(const StaticList& lib32Dirs, const StaticLi
         }
         replace(addLibs[0].begin(), addLibs[0].end(), '/', '\\');
         replace(addLibs[1].begin(), addLibs[1].end(), '/', '\\');
-        const string addLibDir = "<AdditionalLibraryDirectories>";
-        uint arch32Or64 = 0; // start with 32 (assumes projects are ordered 32 then 64 recursive)
-        uint findPos = projectTemplate.find(addLibDir);
-        while (findPos != string::npos) {
-            // Add to output
-            findPos += addLibDir.length();
-            projectTemplate.insert(findPos, addLibs[arch32Or64]);
-            findPos += addLibs[arch32Or64].length();
-            // Get next
-            findPos = projectTemplate.find(addLibDir, findPos + 1);
-            arch32Or64 = !arch32Or64;
-        }
+        // Add to output based on the platform of each configuration
+        slots["libDirs32"].push_back(addLibs[0]);
+        slots["libDirs64"].push_back(addLibs[1]);
     }
 }
 
-void ProjectGenerator::outputDefines(const StaticList& defines, string& projectTemplate)
+void ProjectGenerator::outputDefines(const StaticList& defines, TemplateSlots& slots)
 {
     if (!defines.empty()) {
         string defines2;
         for (const auto& i : defines) {
             defines2 += i + ";";
         }
-        const string addDefines = "<PreprocessorDefinitions>";
-        uint findPos = projectTemplate.find(addDefines);
-        while (findPos != string::npos) {
-            // Add to output
-            findPos += addDefines.length();
-            projectTemplate.insert(findPos, defines2);
-            findPos += defines2.length();
-            // Get next
-            findPos = projectTemplate.find(addDefines, findPos + 1);
-        }
+        // Add to output
+        slots["defines"].push_back(defines2);
     }
 }
 
-void ProjectGenerator::outputASMTools(string& projectTemplate) const
+void ProjectGenerator::outputASMTools(TemplateSlots& slots) const
 {
     if (m_configHelper.isASMEnabled() && (m_includesASM.size() > 0)) {
-        string definesASM = "\r\n\
-    <NASM>\r\n\
-      <IncludePaths>$(ProjectDir);$(ProjectDir)\\template_rootdir;$(ProjectDir)\\template_rootdir\\$(ProjectName)\\x86;%(IncludePaths)</IncludePaths>\r\n\
-      <PreIncludeFiles>config.asm;%(PreIncludeFiles)</PreIncludeFiles>\r\n\
-      <GenerateDebugInformation>false</GenerateDebugInformation>\r\n\
-    </NASM>";
+        // The build customisation props are still used to find the installed assembler
         string propeASM = "\r\n\
   <ImportGroup Label=\"ExtensionSettings\">\r\n\
     <Import Project=\"$(VCTargetsPath)\\BuildCustomizations\\nasm.props\" />\r\n\
-  </ImportGroup>";
-        string targetsASM = "\r\n\
-  <ImportGroup Label=\"ExtensionTargets\">\r\n\
-    <Import Project=\"$(VCTargetsPath)\\BuildCustomizations\\nasm.targets\" />\r\n\
   </ImportGroup>";
         if (!m_configHelper.m_useNASM) {
             // Replace nasm with yasm
-            size_t n = 0;
-            while ((n = definesASM.find("NASM", n)) != string::npos) {
-                definesASM.replace(n, 4, "YASM");
-                n += 4;
-            }
             propeASM.replace(propeASM.find("nasm"), 4, "yasm");
-            targetsASM.replace(targetsASM.find("nasm"), 4, "yasm");
-        }
-        const string findProps = R"(<Import Project="$(VCTargetsPath)\Microsoft.Cpp.props" />)";
-        const string findTargets = R"(<Import Project="$(VCTargetsPath)\Microsoft.Cpp.targets" />)";
-
-        // Add NASM defines
-        const string endPreBuild = "</PreBuildEvent>";
-        uint findPos = projectTemplate.find(endPreBuild);
-        while (findPos != string::npos) {
-            findPos += endPreBuild.length();
-            // Add to output
-            projectTemplate.insert(findPos, definesASM);
-            findPos += definesASM.length();
-            // Get next
-            findPos = projectTemplate.find(endPreBuild, findPos + 1);
         }
 
         // Add NASM build customisation
-        findPos = projectTemplate.find(findProps) + findProps.length();
-        // After <Import Project="$(VCTargetsPath)\Microsoft.Cpp.props" /> add asm props
-        projectTemplate.insert(findPos, propeASM);
-        findPos = projectTemplate.find(findTargets) + findTargets.length();
-        // After <Import Project="$(VCTargetsPath)\Microsoft.Cpp.targets" /> add asm target
-        projectTemplate.insert(findPos, targetsASM);
+        slots["asmProps"].push_back(propeASM);
     }
 }
 
-void ProjectGenerator::outputCUDATools(string& projectTemplate) const
+string ProjectGenerator::getASMBuild(const string& rootDir, const string& libraryName) const
+{
+    // Uses the same options that the nasm/yasm build customisation generated for each platform (-Xvc outputs errors in
+    // the msvc format). Include directories must end with a separator and a trailing backslash would escape the
+    // closing quote.
+    const string assembler = m_configHelper.m_useNASM ? "$(NasmPath)nasm.exe" : "$(YasmPath)yasm.exe";
+    string build = "\r\n\
+      <Command>\"" + assembler + "\" -Xvc -f win$(PlatformArchitecture) -I\"$(ProjectDir)/\" -I\"$(ProjectDir)" +
+        rootDir + "/\" -I\"$(ProjectDir)" + rootDir + '\\' + libraryName + "\\x86/\" -Pconfig.asm \
+-o \"$(IntDir)%(Filename).obj\" \"%(FullPath)\"</Command>\r\n\
+      <Message>%(Filename)%(Extension)</Message>\r\n\
+      <Outputs>$(IntDir)%(Filename).obj</Outputs>\r\n\
+      <BuildInParallel>true</BuildInParallel>";
+    if (m_configHelper.m_useNASM) {
+        // Output a dependency file for each object (yasm does not support this). The files actually read by the
+        // assembler are also recorded by the file tracker of the custom build step which is used by its incremental
+        // checks, while the additional inputs only hold the includes that could be found when generating the project.
+        build.insert(build.find(" -o "), " -MD \"$(IntDir)%(Filename).d\"");
+    }
+    return build;
+}
+
+void ProjectGenerator::outputCUDATools(TemplateSlots& slots) const
 {
     if (m_configHelper.isCUDAEnabled() && (m_includesCU.size() > 0)) {
         // TODO: Add cuda tools
     }
 }
 
-bool ProjectGenerator::outputDependencyLibs(string& projectTemplate, bool program)
+void ProjectGenerator::outputDependencyLibs(TemplateSlots& slots)
 {
     // Check current libs list for valid lib names
     for (auto& i : m_libs) {
@@ -1571,6 +2585,16 @@ bool ProjectGenerator::outputDependencyLibs(string& projectTemplate, bool progra
     }
     buildDependenciesWinRT(libsWinRT, addLibsWinRT);
 
+    // Add the output of any shards which are then combined into the current project
+    const auto shards = m_projectShards.find(m_projectName);
+    if (shards != m_projectShards.end()) {
+        for (const auto& i : shards->second) {
+            const string shardLib = "$(SolutionDir)obj\\$(Configuration)\\$(Platform)\\" + i + "\\" + i;
+            addLibs.push_back(shardLib);
+            addLibsWinRT.push_back(shardLib);
+        }
+    }
+
     if ((m_libs.size() > 0) || (addLibs.size() > 0)) {
         // Create list of additional ffmpeg dependencies
         string addFFmpegLibs[4]; // debug, release, debugDll, releaseDll
@@ -1629,79 +2653,81 @@ bool ProjectGenerator::outputDependencyLibs(string& projectTemplate, bool progra
             addExternDepsWinRT += i;
             addExternDepsWinRT += ".lib;";
         }
-        // Check if winrt builds are enabled
-        bool addWinrt = m_configHelper.isConfigOptionEnabled("winrt") || m_configHelper.isConfigOptionEnabled("uwp");
-        // Add to Additional Dependencies
-        string libLink2[2] = {"<Link>", "<Lib>"};
-        for (uint linkLib = 0; linkLib < (!program ? 2 : 1); linkLib++) {
-            // loop over each debug/release sequence
-            uint findPos = projectTemplate.find(libLink2[linkLib]);
-            for (uint debugRelease = 0; debugRelease < 2; debugRelease++) {
-                uint max = !program ? (((debugRelease == 1) && (linkLib == 0)) ? 2 : 1) : 2;
-                // Libs have:
-                // link:
-                //  DebugDLL|Win32, DebugDLLWinRT|Win32, DebugDLL|x64, DebugDLLWinRT|x64,
-                //  ReleaseDLL|Win32, ReleaseDLLWinRT|Win32, ReleaseDLL|x64, ReleaseDLLWinRT|x64,
-                //  ReleaseDLLStaticDeps|Win32, ReleaseDLLWinRTStaticDeps|Win32, ReleaseDLLStaticDeps|x64,
-                //  ReleaseDLLWinRTStaticDeps|x64
-                // lib:
-                //  Debug32, DebugWinRT|Win32, Debug|x64, DebugWinRT|x64,
-                //  Release|Win32, ReleaseWinRT|Win32, Release|x64, ReleaseWinRT|x64,
-                // Programs have:
-                // link:
-                //  Debug32, Debug|x64,
-                //  DebugDLL|Win32, DebugDLL|x64,
-                //  Release|Win32, Release|x64,
-                //  ReleaseDLL|Win32, ReleaseDLL|x64,
-                for (uint conf = 0; conf < max; conf++) {
-                    // Loop over x32/x64
-                    for (uint arch = 0; arch < 2; arch++) {
-                        // Loop over any WinRT configs
-                        for (uint win = 0; win < ((!program && addWinrt) ? 2 : 1); win++) {
-                            findPos = projectTemplate.find("%(AdditionalDependencies)", findPos);
-                            if (findPos == string::npos) {
-                                outputError("Failed finding %(AdditionalDependencies) in template.");
-                                return false;
-                            }
-                            // Add in ffmpeg inter-dependencies
-                            uint addIndex = debugRelease;
-                            if ((linkLib == 0) && (!program || (conf % 2 != 0))) {
-                                // Use DLL libs
-                                addIndex += 2;
-                            }
-                            string addString;
-                            // If the dependency is actually for one of the ffmpeg libs then we can ignore it in
-                            // static linking mode as this just causes unnecessary code bloat
-                            if (linkLib == 0) {
-                                if (win == 0) {
-                                    addString = addFFmpegLibs[addIndex];
-                                } else {
-                                    addString = addFFmpegLibsWinRT[addIndex];
-                                }
-                            }
-                            // Add in normal dependencies
-                            addIndex = debugRelease;
-                            if ((linkLib == 0) && (((!program) && (conf < 1)) || (program && (conf % 2 != 0)))) {
-                                // Use DLL libs
-                                addIndex += 2;
-                            }
-                            if (win == 0) {
-                                addString += addDeps[addIndex];
-                                addString += addExternDeps;
-                            } else {
-                                addString += addDepsWinRT[addIndex];
-                                addString += addExternDepsWinRT;
-                            }
-                            projectTemplate.insert(findPos, addString);
-                            findPos += addString.length();
-                            // Get next
-                            findPos = projectTemplate.find(libLink2[linkLib], findPos + 1);
+        // Add to Additional Dependencies for each combination of ffmpeg and normal dependency type
+        for (uint ffmpegIndex = 0; ffmpegIndex < 5; ffmpegIndex++) {
+            for (uint addIndex = 0; addIndex < 4; addIndex++) {
+                for (uint win = 0; win < 2; win++) {
+                    string addString;
+                    // If the dependency is actually for one of the ffmpeg libs then we can ignore it in
+                    // static linking mode as this just causes unnecessary code bloat
+                    if (ffmpegIndex < 4) {
+                        if (win == 0) {
+                            addString = addFFmpegLibs[ffmpegIndex];
+                        } else {
+                            addString = addFFmpegLibsWinRT[ffmpegIndex];
                         }
                     }
+                    // Add in normal dependencies
+                    if (win == 0) {
+                        addString += addDeps[addIndex];
+                        addString += addExternDeps;
+                    } else {
+                        addString += addDepsWinRT[addIndex];
+                        addString += addExternDepsWinRT;
+                    }
+                    slots["dependencies" + to_string(ffmpegIndex) + to_string(addIndex) + to_string(win)].push_back(
+                        addString);
                 }
             }
         }
     }
+}
+
+bool ProjectGenerator::outputProjectReferences(TemplateSlots& slots) const
+{
+    map<string, string> keys;
+    buildProjectGUIDs(keys);
+
+    // Any shards must always be built first as their output is combined into the current project
+    const auto shards = m_projectShards.find(m_projectName);
+    if (shards != m_projectShards.end()) {
+        string references = "\r\n  <ItemGroup>";
+        for (const auto& i : shards->second) {
+            references += "\r\n    <ProjectReference Include=\"" + i + ".vcxproj\">\r\n\
+      <Project>{" + keys[i] + "}</Project>\r\n\
+      <LinkLibraryDependencies>false</LinkLibraryDependencies>\r\n\
+      <ReferenceOutputAssembly>false</ReferenceOutputAssembly>\r\n\
+    </ProjectReference>";
+        }
+        references += "\r\n  </ItemGroup>";
+        slots["sources"].front() += references;
+    }
+
+    const auto libs = m_projectLibs.find(m_projectName);
+    if ((libs == m_projectLibs.end()) || libs->second.empty()) {
+        return true;
+    }
+
+    // The referenced projects only need to be built first when linking a dll. The libraries are already added to the
+    // additional dependencies so the references are not linked
+    string references = "\r\n  <ItemGroup Condition=\"'$(ConfigurationType)'=='DynamicLibrary'\">";
+    for (const auto& i : libs->second) {
+        // Check if this library has a known key
+        const auto key = keys.find(i);
+        if (key == keys.end()) {
+            outputError("Unknown library dependency. Could not determine project key (" + i + ")");
+            return false;
+        }
+        references += "\r\n    <ProjectReference Include=\"" + i + ".vcxproj\">\r\n\
+      <Project>{" + key->second + "}</Project>\r\n\
+      <LinkLibraryDependencies>false</LinkLibraryDependencies>\r\n\
+      <ReferenceOutputAssembly>false</ReferenceOutputAssembly>\r\n\
+    </ProjectReference>";
+    }
+    references += "\r\n  </ItemGroup>";
+
+    // Add after the source files
+    slots["sources"].front() += references;
     return true;
 }
 
@@ -1766,3 +2792,391 @@ void ProjectGenerator::outputStripWinRTSolution(string& solutionFile)
         found = solutionFile.find(search, found);
     }
 }
+
+void ProjectGenerator::outputStripConfigurations(string& projectTemplate, const bool program) const
+{
+    // Search through template for the configuration of each section
+    const string searches[] = {"<ProjectConfiguration Include=\"", "'$(Configuration)|$(Platform)'=='"};
+    for (const auto& search : searches) {
+        uint found = projectTemplate.find(search);
+        while (found != string::npos) {
+            const uint configStart = found + search.length();
+            const string configuration =
+                projectTemplate.substr(configStart, projectTemplate.find_first_of("'\"", configStart) - configStart);
+            if (isConfigurationEnabled(configuration, program)) {
+                found = projectTemplate.find(search, configStart);
+                continue;
+            }
+            // Remove the entire section along with its line ending
+            const uint tagPos = projectTemplate.rfind('<', found);
+            const uint startPos = projectTemplate.find_last_of(g_endLine, tagPos - 1) + 1;
+            const string endTag =
+                "</" + projectTemplate.substr(tagPos + 1, projectTemplate.find_first_of(" >", tagPos) - tagPos - 1) + '>';
+            uint endPos = projectTemplate.find(endTag, found) + endTag.length();
+            endPos = projectTemplate.find_first_not_of(g_endLine, endPos);
+            projectTemplate.erase(startPos, endPos - startPos);
+            // Find next occurence
+            found = projectTemplate.find(search, startPos);
+        }
+    }
+}
+
+void ProjectGenerator::outputSplitProps(string& projectTemplate, const string& propsName, string& retProps)
+{
+    // Use the same line endings as the template
+    const uint lineEnd = projectTemplate.find_first_of(g_endLine);
+    const string endLine =
+        projectTemplate.substr(lineEnd, projectTemplate.find_first_not_of(g_endLine, lineEnd) - lineEnd);
+    retProps = "<?xml version=\"1.0\" encoding=\"utf-8\"?>" + endLine +
+        "<Project ToolsVersion=\"4.0\" xmlns=\"http://schemas.microsoft.com/developer/msbuild/2003\">" + endLine;
+
+    // Settings that are changed for each project remain in the project
+    const string keepTags[] = {"PreprocessorDefinitions", "AdditionalIncludeDirectories",
+        "AdditionalLibraryDirectories", "AdditionalDependencies", "ForcedIncludeFiles", "PrecompiledHeader"};
+    const string groupStart = "<ItemDefinitionGroup ";
+    uint found = projectTemplate.find(groupStart);
+    while (found != string::npos) {
+        const string groupTag = projectTemplate.substr(found, projectTemplate.find('>', found) - found + 1);
+        string group;
+        // Loop over each tool section in the group
+        uint sectionPos = projectTemplate.find('<', found + groupTag.length());
+        while (projectTemplate.compare(sectionPos, 2, "</") != 0) {
+            const string tag =
+                projectTemplate.substr(sectionPos + 1, projectTemplate.find('>', sectionPos) - sectionPos - 1);
+            const string endTag = "</" + tag + '>';
+            string section;
+            uint linePos = projectTemplate.find('<', sectionPos + 1);
+            while (projectTemplate.compare(linePos, endTag.length(), endTag) != 0) {
+                const string name =
+                    projectTemplate.substr(linePos + 1, projectTemplate.find_first_of(" >", linePos) - linePos - 1);
+                const uint lineStart = projectTemplate.find_last_of(g_endLine, linePos) + 1;
+                const uint lineNext =
+                    projectTemplate.find_first_not_of(g_endLine, projectTemplate.find_first_of(g_endLine, linePos));
+                const string line = projectTemplate.substr(lineStart, lineNext - lineStart);
+                bool keep = (line.find("template_") != string::npos);
+                for (const auto& i : keepTags) {
+                    keep = keep || (name == i);
+                }
+                if (keep) {
+                    linePos = projectTemplate.find('<', lineNext);
+                    continue;
+                }
+                // Move the setting into the props file
+                section += line;
+                projectTemplate.erase(lineStart, lineNext - lineStart);
+                linePos = projectTemplate.find('<', lineStart);
+            }
+            if (!section.empty()) {
+                group += "    <" + tag + '>' + endLine + section + "    " + endTag + endLine;
+            }
+            sectionPos = projectTemplate.find('<', linePos + endTag.length());
+        }
+        if (!group.empty()) {
+            retProps += "  " + groupTag + endLine + group + "  </ItemDefinitionGroup>" + endLine;
+        }
+        found = projectTemplate.find(groupStart, sectionPos);
+    }
+    retProps += "</Project>" + endLine;
+
+    // Import the props file after the default property sheets
+    const string userMacros = "<PropertyGroup Label=\"UserMacros\" />";
+    found = projectTemplate.find(userMacros);
+    if (found != string::npos) {
+        projectTemplate.insert(projectTemplate.find_last_of(g_endLine, found) + 1,
+            "  <ImportGroup Label=\"PropertySheets\">" + endLine + "    <Import Project=\"$(MSBuildThisFileDirectory)" +
+                propsName + "\" />" + endLine + "  </ImportGroup>" + endLine);
+    }
+}
+
+void ProjectGenerator::outputStripConfigurationsSolution(string& solutionFile) const
+{
+    // Search through the solution configurations
+    uint found = solutionFile.find("GlobalSection(SolutionConfigurationPlatforms)");
+    if (found == string::npos) {
+        return;
+    }
+    found = solutionFile.find_first_of(g_endLine, found);
+    uint end = solutionFile.find("EndGlobalSection", found);
+    while (found < end) {
+        const uint start = solutionFile.find_first_not_of(g_endLine, found);
+        const uint lineEnd = solutionFile.find_first_of(g_endLine, start);
+        const uint configStart = solutionFile.find_first_not_of(" \t", start);
+        const string configuration = solutionFile.substr(configStart, solutionFile.find(' ', configStart) - configStart);
+        if ((lineEnd < end) && !isConfigurationEnabled(configuration, false)) {
+            // Remove the entire line
+            solutionFile.erase(found, lineEnd - found);
+            end -= lineEnd - found;
+            continue;
+        }
+        found = lineEnd;
+    }
+}
+
+void ProjectGenerator::outputAddPGO(string& projectTemplate)
+{
+    const string pgoConfigs[] = {"ReleasePGInstrument", "ReleasePGOptimize"};
+    const string pgoLinks[] = {"PGInstrument", "PGOptimization"};
+    const string pgoArchs[] = {"x64", "x86", "ARM64"};
+    const string search = "ReleaseDLL|";
+    const string pgoDatabase = "<ProfileGuidedDatabase>";
+
+    // Find each ReleaseDLL section along with the position after its last consecutive sibling section
+    map<uint, StaticList> sections;
+    findTemplateSections(projectTemplate, search, sections);
+
+    // Add each configuration after the existing sections (going backwards so that positions remain valid)
+    for (auto i = sections.rbegin(); i != sections.rend(); ++i) {
+        string pgoSections;
+        for (uint j = 0; j < sizeof(pgoConfigs) / sizeof(pgoConfigs[0]); j++) {
+            for (const auto& k : i->second) {
+                string section = k;
+                findAndReplace(section, "ReleaseDLL", pgoConfigs[j]);
+                // Enable whole program optimisation and link time code generation
+                const string options[] = {"<ClCompile>", "<WholeProgramOptimization>true</WholeProgramOptimization>",
+                    "<Link>", "<LinkTimeCodeGeneration>" + pgoLinks[j] + "</LinkTimeCodeGeneration>"};
+                for (uint m = 0; m < sizeof(options) / sizeof(options[0]); m += 2) {
+                    uint pos = section.find(options[m]);
+                    if (pos == string::npos) {
+                        continue;
+                    }
+                    // Add as a new line using the same indent and line ending as the following line
+                    pos = section.find_first_of(g_endLine, pos);
+                    const uint lineStart = section.find_first_not_of(g_endLine, pos);
+                    const uint indentEnd = section.find_first_not_of(" \t", lineStart);
+                    section.insert(lineStart,
+                        section.substr(lineStart, indentEnd - lineStart) + options[m + 1] +
+                            section.substr(pos, lineStart - pos));
+                }
+                // Both configurations must share the same profile database
+                uint pos = section.find(pgoDatabase);
+                if (pos != string::npos) {
+                    pos += pgoDatabase.length();
+                    section.replace(
+                        pos, section.find('<', pos) - pos, "$(OutDir)\\pgo\\$(Platform)\\$(TargetName).pgd");
+                }
+                // Output to a separate directory so that the default binaries are not overwritten
+                for (const auto& m : pgoArchs) {
+                    findAndReplace(section, "$(OutDir)\\bin\\" + m + '\\', "$(OutDir)\\bin\\" + m + "\\pgo\\");
+                    findAndReplace(section, "$(OutDir)\\lib\\" + m + '\\', "$(OutDir)\\lib\\" + m + "\\pgo\\");
+                    // Any external libraries are still found in the default directory
+                    findAndReplace(section, "<AdditionalLibraryDirectories>$(OutDir)\\lib\\" + m + "\\pgo\\;",
+                        "<AdditionalLibraryDirectories>$(OutDir)\\lib\\" + m + "\\pgo\\;$(OutDir)\\lib\\" + m + "\\;");
+                }
+                pgoSections += section;
+            }
+        }
+        projectTemplate.insert(i->first, pgoSections);
+    }
+}
+
+void ProjectGenerator::outputAddPGOSolution(string& solutionFile)
+{
+    const string pgoConfigs[] = {"ReleasePGInstrument", "ReleasePGOptimize"};
+
+    // Copy each ReleaseDLL solution configuration to the end of the configuration list
+    const string search = "ReleaseDLL|";
+    uint found = solutionFile.find(search);
+    if (found == string::npos) {
+        return;
+    }
+    const uint endPos = solutionFile.find_last_of(g_endLine, solutionFile.find("EndGlobalSection", found)) + 1;
+    string pgoLines;
+    for (const auto& i : pgoConfigs) {
+        found = solutionFile.find(search);
+        while ((found != string::npos) && (found < endPos)) {
+            const uint start = solutionFile.find_last_of(g_endLine, found) + 1;
+            const uint end = solutionFile.find_first_not_of(g_endLine, solutionFile.find_first_of(g_endLine, found));
+            string line = solutionFile.substr(start, end - start);
+            findAndReplace(line, "ReleaseDLL", i);
+            pgoLines += line;
+            // Find next occurence
+            found = solutionFile.find(search, end);
+        }
+    }
+    solutionFile.insert(endPos, pgoLines);
+}
+
+void ProjectGenerator::findTemplateSections(
+    const string& projectTemplate, const string& search, map<uint, StaticList>& retSections)
+{
+    uint found = projectTemplate.find(search);
+    while (found != string::npos) {
+        const uint tagPos = projectTemplate.rfind('<', found);
+        const uint startPos = projectTemplate.find_last_of(g_endLine, tagPos - 1) + 1;
+        const string tag = projectTemplate.substr(tagPos, projectTemplate.find_first_of(" >", tagPos) - tagPos);
+        const string endTag = "</" + tag.substr(1) + '>';
+        uint endPos = projectTemplate.find(endTag, found);
+        endPos = projectTemplate.find_first_not_of(g_endLine, endPos + endTag.length());
+        const string section = projectTemplate.substr(startPos, endPos - startPos);
+        // Skip over any following sections of the same type
+        uint insertPos = endPos;
+        while (projectTemplate.compare(projectTemplate.find_first_not_of(" \t", insertPos), tag.length(), tag) == 0) {
+            insertPos = projectTemplate.find(endTag, insertPos);
+            insertPos = projectTemplate.find_first_not_of(g_endLine, insertPos + endTag.length());
+        }
+        retSections[insertPos].push_back(section);
+        found = projectTemplate.find(search, endPos);
+    }
+}
+
+void ProjectGenerator::outputAddISA(string& projectTemplate) const
+{
+    // Find each ReleaseDLL x64 section along with the position after its last consecutive sibling section
+    map<uint, StaticList> sections;
+    findTemplateSections(projectTemplate, "ReleaseDLL|x64", sections);
+
+    // Add each configuration after the existing sections (going backwards so that positions remain valid)
+    const string clCompile = "<ClCompile>";
+    for (auto i = sections.rbegin(); i != sections.rend(); ++i) {
+        string isaSections;
+        for (const auto& j : m_configHelper.m_isaVariants) {
+            string isaDir = j;
+            transform(isaDir.begin(), isaDir.end(), isaDir.begin(), tolower);
+            const string instructionSet = (j == "AVX2") ? "AdvancedVectorExtensions2" : "AdvancedVectorExtensions512";
+            for (const auto& k : i->second) {
+                string section = k;
+                findAndReplace(section, "ReleaseDLL", "Release" + j);
+                // Enable the enhanced instruction set
+                uint pos = section.find(clCompile);
+                if (pos != string::npos) {
+                    // Add as a new line using the same indent and line ending as the following line
+                    pos = section.find_first_of(g_endLine, pos);
+                    const uint lineStart = section.find_first_not_of(g_endLine, pos);
+                    const uint indentEnd = section.find_first_not_of(" \t", lineStart);
+                    section.insert(lineStart,
+                        section.substr(lineStart, indentEnd - lineStart) + "<EnableEnhancedInstructionSet>" +
+                            instructionSet + "</EnableEnhancedInstructionSet>" + section.substr(pos, lineStart - pos));
+                }
+                // Output to a separate directory so that the default binaries are not overwritten
+                findAndReplace(section, "$(OutDir)\\bin\\x64\\", "$(OutDir)\\bin\\x64\\" + isaDir + '\\');
+                findAndReplace(section, "$(OutDir)\\lib\\x64\\", "$(OutDir)\\lib\\x64\\" + isaDir + '\\');
+                // Any external libraries are still found in the default directory
+                findAndReplace(section, "<AdditionalLibraryDirectories>$(OutDir)\\lib\\x64\\" + isaDir + "\\;",
+                    "<AdditionalLibraryDirectories>$(OutDir)\\lib\\x64\\" + isaDir + "\\;$(OutDir)\\lib\\x64\\;");
+                isaSections += section;
+            }
+        }
+        projectTemplate.insert(i->first, isaSections);
+    }
+}
+
+void ProjectGenerator::outputAddISASolution(string& solutionFile) const
+{
+    // Copy each ReleaseDLL x64 solution configuration to the end of the configuration list
+    const string search = "ReleaseDLL|x64";
+    uint found = solutionFile.find(search);
+    if (found == string::npos) {
+        return;
+    }
+    const uint endPos = solutionFile.find_last_of(g_endLine, solutionFile.find("EndGlobalSection", found)) + 1;
+    string isaLines;
+    for (const auto& i : m_configHelper.m_isaVariants) {
+        found = solutionFile.find(search);
+        while ((found != string::npos) && (found < endPos)) {
+            const uint start = solutionFile.find_last_of(g_endLine, found) + 1;
+            const uint end = solutionFile.find_first_not_of(g_endLine, solutionFile.find_first_of(g_endLine, found));
+            string line = solutionFile.substr(start, end - start);
+            findAndReplace(line, "ReleaseDLL", "Release" + i);
+            isaLines += line;
+            // Find next occurence
+            found = solutionFile.find(search, end);
+        }
+    }
+    solutionFile.insert(endPos, isaLines);
+}
+
+void ProjectGenerator::outputAddARM64(string& projectTemplate)
+{
+    // Find each x64 section along with the position after its last consecutive sibling section
+    map<uint, StaticList> sections;
+    findTemplateSections(projectTemplate, "|x64", sections);
+
+    // Add each configuration after the existing sections (going backwards so that positions remain valid)
+    for (auto i = sections.rbegin(); i != sections.rend(); ++i) {
+        string armSections;
+        for (const auto& j : i->second) {
+            string section = j;
+            findAndReplace(section, "x64", "ARM64");
+            findAndReplace(section, "MachineX64", "MachineARM64");
+            armSections += section;
+        }
+        projectTemplate.insert(i->first, armSections);
+    }
+}
+
+void ProjectGenerator::outputAddARM64Solution(string& solutionFile)
+{
+    // Copy each x64 solution configuration to the end of the configuration list
+    const string search = "|x64";
+    uint found = solutionFile.find(search);
+    if (found == string::npos) {
+        return;
+    }
+    const uint endPos = solutionFile.find_last_of(g_endLine, solutionFile.find("EndGlobalSection", found)) + 1;
+    string armLines;
+    while ((found != string::npos) && (found < endPos)) {
+        const uint start = solutionFile.find_last_of(g_endLine, found) + 1;
+        const uint end = solutionFile.find_first_not_of(g_endLine, solutionFile.find_first_of(g_endLine, found));
+        string line = solutionFile.substr(start, end - start);
+        findAndReplace(line, "x64", "ARM64");
+        armLines += line;
+        // Find next occurence
+        found = solutionFile.find(search, end);
+    }
+    solutionFile.insert(endPos, armLines);
+}
+
+void ProjectGenerator::outputConvertShard(string& projectFile)
+{
+    // Change any dll configurations to static libraries
+    const string dynamicLib = "<ConfigurationType>DynamicLibrary</ConfigurationType>";
+    const string condition = "Condition=\"";
+    StaticList dllConfigs;
+    uint findPos = projectFile.find(dynamicLib);
+    while (findPos != string::npos) {
+        const uint startPos = projectFile.rfind(condition, findPos) + condition.length();
+        dllConfigs.push_back(projectFile.substr(startPos, projectFile.find('"', startPos) - startPos));
+        projectFile.replace(findPos, dynamicLib.length(), "<ConfigurationType>StaticLibrary</ConfigurationType>");
+        findPos = projectFile.find(dynamicLib, findPos);
+    }
+
+    // The sources must still be compiled with the same defines as the dll that they are combined into
+    const string defines = "<PreprocessorDefinitions>";
+    for (const auto& i : dllConfigs) {
+        findPos = projectFile.find("<ItemDefinitionGroup " + condition + i + '"');
+        if (findPos == string::npos) {
+            continue;
+        }
+        const uint endPos = projectFile.find("</ItemDefinitionGroup>", findPos);
+        findPos = projectFile.find(defines, findPos);
+        if (findPos < endPos) {
+            projectFile.insert(findPos + defines.length(), "_WINDLL;");
+        }
+    }
+
+    // Replace the link and lib settings so that the library is output to the intermediate directory
+    const string lib = "<Lib>\r\n\
+      <OutputFile>$(IntDir)$(TargetName)$(TargetExt)</OutputFile>\r\n\
+      <AdditionalOptions>/IGNORE:4006,4221,4049,4217,4197,4099,4264 %(AdditionalOptions)</AdditionalOptions>\r\n\
+    </Lib>";
+    const string sections[] = {"Link", "Lib"};
+    for (const auto& i : sections) {
+        const string startTag = '<' + i + '>';
+        const string endTag = "</" + i + '>';
+        findPos = projectFile.find(startTag);
+        while (findPos != string::npos) {
+            const uint endPos = projectFile.find(endTag, findPos) + endTag.length();
+            projectFile.replace(findPos, endPos - findPos, lib);
+            findPos = projectFile.find(startTag, findPos + lib.length());
+        }
+    }
+
+    // Shards are named after the project instead of the library
+    const string targetName = "<TargetName>";
+    findPos = projectFile.find(targetName);
+    while (findPos != string::npos) {
+        findPos += targetName.length();
+        projectFile.replace(findPos, projectFile.find('<', findPos) - findPos, "$(ProjectName)");
+        findPos = projectFile.find(targetName, findPos);
+    }
+}
@@ -483,6 +483,19 @@ void ProjectGenerator::buildProjectGUIDs(map<string, string>& keys) const
         keys["avplay"] = "E2A6865D-BD68-45B4-8130-EFD620F2C7EB";
         keys["avprobe"] = "147A422A-FA63-4724-A5D9-08B1CAFDAB59";
     }
+
+    // Shard projects are given keys based on a hash of their name so that they remain the same between runs
+    for (const auto& i : m_projectShards) {
+        for (const auto& j : i.second) {
+            string key = getHash(j) + getHash(j + i.first);
+            transform(key.begin(), key.end(), key.begin(), toupper);
+            key.insert(20, 1, '-');
+            key.insert(16, 1, '-');
+            key.insert(12, 1, '-');
+            key.insert(8, 1, '-');
+            keys[j] = key;
+        }
+    }
 }
 
 void ProjectGenerator::buildProjectDCEs(map<string, DCEParams>&, map<string, DCEParams>& variablesDCE) const
@@ -21,56 +21,12 @@
 #include "projectGenerator.h"
 
 #include <algorithm>
+#include <thread>
 #include <utility>
 
-bool ProjectGenerator::runCompiler(
-    const vector<string>& includeDirs, map<string, vector<string>>& directoryObjects, const int runType) const
-{
-#ifdef _MSC_VER
-    // If compiled by msvc then only msvc builds are supported
-    return runMSVC(includeDirs, directoryObjects, runType);
-#else
-    // Otherwise only gcc and mingw are supported
-    return runGCC(includeDirs, directoryObjects, runType);
-#endif
-}
-
-bool ProjectGenerator::runMSVC(
-    const vector<string>& includeDirs, map<string, vector<string>>& directoryObjects, int runType) const
-{
-    // Create a test file to read in definitions
-    string outDir = m_configHelper.m_outDirectory;
-    m_configHelper.makeFileGeneratorRelative(outDir, outDir);
-    vector<string> includeDirs2 = includeDirs;
-    includeDirs2.insert(includeDirs2.begin(), outDir + "include/");
-    includeDirs2.insert(includeDirs2.begin(), m_configHelper.m_solutionDirectory);
-    includeDirs2.insert(includeDirs2.begin(), m_configHelper.m_rootDirectory);
-    string extraCl;
-    for (auto& i : includeDirs2) {
-        uint findPos2 = i.find("$(OutDir)");
-        if (findPos2 != string::npos) {
-            i.replace(findPos2, 9, outDir);
-        }
-        findPos2 = i.find("$(");
-        if (findPos2 != string::npos) {
-            i.replace(findPos2, 2, "%");
-        }
-        findPos2 = i.find(')');
-        if (findPos2 != string::npos) {
-            i.replace(findPos2, 1, "%");
-        }
-        if (i.length() == 0) {
-            i = "./";
-        } else if ((i.find(':') == string::npos) && (i.find_first_of("./%") != 0)) {
-            i.insert(0, "./");
-        }
-        extraCl += " /I\"" + i + '\"';
-    }
-    string tempFolder = m_tempDirectory + m_projectName;
-
-    // Use Microsoft compiler to pass the test file and retrieve declarations
-    string launchBat = "@echo off\nsetlocal enabledelayedexpansion\nset CALLDIR=%CD%\n";
-    launchBat += "if \"%PROCESSOR_ARCHITECTURE%\"==\"AMD64\" (\n\
+// Batch commands used to find and setup a msvc build environment
+static const string g_msvcVarsBatch = "@echo off\nsetlocal enabledelayedexpansion\nset CALLDIR=%CD%\n\
+if \"%PROCESSOR_ARCHITECTURE%\"==\"AMD64\" (\n\
     set SYSARCH=64\n\
 ) else if \"%PROCESSOR_ARCHITECTURE%\"==\"x86\" (\n\
     if \"%PROCESSOR_ARCHITEW6432%\"==\"AMD64\" (\n\
@@ -128,218 +84,653 @@ echo fatal error : An installed version of Visual Studio could not be detected.
 exit /b 1\n\
 :MSVCVarsDone\n\
 popd\n";
-    launchBat += "mkdir \"" + m_tempDirectory + "\" > nul 2>&1\n";
-    launchBat += "mkdir \"" + tempFolder + "\" > nul 2>&1\n";
-    for (auto& j : directoryObjects) {
-        const uint rowSize = 32;
-        uint numClCalls = static_cast<uint>(ceilf(static_cast<float>(j.second.size()) / static_cast<float>(rowSize)));
-        uint totalPos = 0;
-        string dirName = tempFolder + "/" + j.first;
-        if (j.first.length() > 0) {
-            // Need to make output directory so compile doesn't fail outputting
-            launchBat += "mkdir \"" + dirName + "\" > nul 2>&1\n";
-        }
-        string runCommands;
-        // Check type of compiler call
-        if (runType == 0) {
-            runCommands = "/FR\"" + dirName + "/\"" + " /Fo\"" + dirName + "/\"";
-        } else if (runType == 1) {
-            runCommands = "/EP /P";
-        }
-
-        // Split calls into groups of 50 to prevent batch file length limit
-        for (uint i = 0; i < numClCalls; i++) {
-            launchBat += "cl.exe ";
-            launchBat += extraCl + R"( /D"_DEBUG" /D"WIN32" /D"_WINDOWS" /D"HAVE_AV_CONFIG_H" /FI"compat.h" )" +
-                runCommands + " /c /MP /w /nologo";
-            uint uiStartPos = totalPos;
-            for (; totalPos < min(uiStartPos + rowSize, j.second.size()); totalPos++) {
-                if (runType == 0) {
-                    m_configHelper.makeFileGeneratorRelative(j.second[totalPos], j.second[totalPos]);
-                }
-                launchBat += " \"" + j.second[totalPos] + "\"";
-            }
-            launchBat += " > ffvs_log.txt 2>&1\nif %errorlevel% neq 0 goto exitFail\n";
-        }
-        if (runType == 1) {
-            launchBat += "move *.i " + dirName + "/ >nul 2>&1\n";
+
+bool ProjectGenerator::runCompiler(
+    const vector<string>& includeDirs, map<string, vector<string>>& directoryObjects)
+{
+#ifdef _MSC_VER
+    // If compiled by msvc then only msvc builds are supported
+    return runMSVC(includeDirs, directoryObjects);
+#else
+    // Otherwise only gcc and mingw are supported
+    return runGCC(includeDirs, directoryObjects);
+#endif
+}
+
+bool ProjectGenerator::runPreProcessor(const vector<string>& includeDirs, map<string, string>& sourceFiles)
+{
+    // The compiler flags are shared by all files and form part of each files cache key
+    string responseFile;
+    buildCompilerResponseFile(includeDirs, responseFile);
+    const string flags = m_configHelper.m_toolchain + '\n' + responseFile;
+
+    // Check for any files that have previously been pre-processed with the same inputs
+    map<string, string> uncachedFiles;
+    map<string, string> cacheKeys;
+    map<string, string> fileHashes;
+    for (auto& i : sourceFiles) {
+        const string key = getHash(flags + '\n' + i.first + '\n' + i.second);
+        if (!findPreProcessorCache(key, fileHashes, i.second)) {
+            uncachedFiles[i.first] = i.second;
+            cacheKeys[i.first] = key;
         }
     }
-    if (runType == 0) {
-        launchBat += "del /F /S /Q *.obj >nul 2>&1\n";
+    if (uncachedFiles.empty()) {
+        return true;
     }
-    launchBat += "del ffvs_log.txt >nul 2>&1\n";
-    launchBat += "exit /b 0\n:exitFail\n";
-    if (runType == 1) {
-        launchBat += "del /F /S /Q *.i >nul 2>&1\n";
+    outputInfo("Pre-processing " + to_string(uncachedFiles.size()) + " of " + to_string(sourceFiles.size()) +
+        " files (remaining files found in cache)");
+
+#ifdef _MSC_VER
+    // If compiled by msvc then only msvc builds are supported
+    if (!runPreProcessorMSVC(responseFile, uncachedFiles)) {
+        return false;
     }
-    launchBat += "rmdir /S /Q " + m_tempDirectory + "\nexit /b 1";
-    if (!writeToFile("ffvs_compile.bat", launchBat)) {
+#else
+    // Otherwise only gcc and mingw are supported
+    if (!runPreProcessorGCC(responseFile, uncachedFiles)) {
         return false;
     }
+#endif
+
+    // Get the files included by each source and store the results in the cache
+    for (auto& i : uncachedFiles) {
+        set<string> includes;
+        removePreProcessorLineMarkers(i.first, i.second, includes);
+        outputPreProcessorCache(cacheKeys[i.first], includes, fileHashes, i.second);
+        sourceFiles[i.first] = move(i.second);
+    }
+    return true;
+}
+
+void ProjectGenerator::buildCompilerIncludeDirs(const vector<string>& includeDirs, vector<string>& retIncludeDirs) const
+{
+    string outDir = m_configHelper.m_outDirectory;
+    m_configHelper.makeFileGeneratorRelative(outDir, outDir);
+    retIncludeDirs = includeDirs;
+    retIncludeDirs.insert(retIncludeDirs.begin(), outDir + "include/");
+    retIncludeDirs.insert(retIncludeDirs.begin(), m_configHelper.m_solutionDirectory);
+    retIncludeDirs.insert(retIncludeDirs.begin(), m_configHelper.m_rootDirectory);
+    for (auto& i : retIncludeDirs) {
+        uint findPos2 = i.find("$(OutDir)");
+        if (findPos2 != string::npos) {
+            i.replace(findPos2, 9, outDir);
+        }
+        findPos2 = i.find("$(");
+        if (findPos2 != string::npos) {
+            i.replace(findPos2, 2, "%");
+        }
+        findPos2 = i.find(')');
+        if (findPos2 != string::npos) {
+            i.replace(findPos2, 1, "%");
+        }
+        if (i.length() == 0) {
+            i = "./";
+        } else if ((i.find(':') == string::npos) && (i.find_first_of("./%") != 0)) {
+            i.insert(0, "./");
+        }
+    }
+}
+
+void ProjectGenerator::buildCompilerResponseFile(const vector<string>& includeDirs, string& retResponseFile) const
+{
+    vector<string> includeDirs2;
+    buildCompilerIncludeDirs(includeDirs, includeDirs2);
+    retResponseFile.clear();
+#ifdef _MSC_VER
+    for (const auto& i : includeDirs2) {
+        retResponseFile += "/I\"" + i + "\"\n";
+    }
+    retResponseFile += "/D\"_DEBUG\"\n/D\"WIN32\"\n/D\"_WINDOWS\"\n/D\"HAVE_AV_CONFIG_H\"\n/FI\"compat.h\"\n";
+    if (!m_configHelper.m_componentConfigs.empty()) {
+        // Component options must be available to every file that is scanned
+        retResponseFile += "/FI\"config_components.h\"\n";
+    }
+#else
+    for (const auto& i : includeDirs2) {
+        retResponseFile += "-I\"" + i + "\"\n";
+    }
+    retResponseFile += "-D_DEBUG\n-DHAVE_AV_CONFIG_H\n";
+    if (!m_configHelper.m_componentConfigs.empty()) {
+        // Component options must be available to every file that is scanned
+        retResponseFile += "-include \"config_components.h\"\n";
+    }
+    // Check if gcc or mingw
+    if (m_configHelper.m_toolchain.find("mingw") != string::npos) {
+        retResponseFile += "-DWIN32\n-D_WINDOWS\n";
+    }
+#endif
+}
+
+uint ProjectGenerator::getCompilerBatchSize(const uint numFiles)
+{
+    // Spread the files evenly so that there is a single compiler call for each available core
+    const uint numCores = max(thread::hardware_concurrency(), 1U);
+    return max<uint>((numFiles + numCores - 1) / numCores, 1);
+}
+
+string ProjectGenerator::getCompiler(const int runType) const
+{
+    // clang-cl accepts the same options as cl so the response files can be shared, however it is unable to generate
+    // the browse information used for symbol detection
+    if ((m_configHelper.m_toolchain == "clang-cl") && (runType != 0)) {
+        return "clang-cl.exe";
+    }
+    return "cl.exe";
+}
+
+bool ProjectGenerator::findMSVCEnvironment()
+{
+    if (!m_msvcEnvironment.empty()) {
+        return true;
+    }
 
-    if (0 != system("ffvs_compile.bat")) {
+    // Setup the build environment once and then read back all of the resulting environment variables
+    string launchBat = g_msvcVarsBatch;
+    launchBat += "set\nexit /b 0\n";
+    if (!writeToFile("ffvs_vcvars.bat", launchBat)) {
+        return false;
+    }
+    string output;
+    string errors;
+    const bool ret = runProcess("ffvs_vcvars.bat", "", output, errors);
+    deleteFile("ffvs_vcvars.bat");
+    if (!ret) {
         outputError("Errors detected during compilation :-");
-        string testOutput;
-        if (loadFromFile("ffvs_log.txt", testOutput)) {
-            // Output errors from ffvs_log.txt
-            bool error = false;
-            bool missingVs = false;
-            bool missingDeps = false;
-            uint findPos = testOutput.find(" error ");
-            while (findPos != string::npos) {
-                // find end of line
-                uint findPos2 = testOutput.find_first_of("\n(", findPos + 1);
-                string temp = testOutput.substr(findPos + 1, findPos2 - findPos - 1);
-                outputError(temp, false);
-                findPos = testOutput.find(" error ", findPos2 + 1);
-                // Check what type of error was found
-                if (!missingDeps && (temp.find("open include file") != string::npos)) {
-                    missingDeps = true;
-                } else if (!missingVs && (temp.find("Visual Studio could not be detected") != string::npos)) {
-                    missingVs = true;
-                } else {
-                    error = true;
-                }
+        outputMSVCErrors();
+        return false;
+    }
+
+    // Each line of output contains a single variable
+    uint findPos = 0;
+    while (findPos < output.length()) {
+        uint findPos2 = output.find('\n', findPos);
+        findPos2 = (findPos2 == string::npos) ? output.length() : findPos2;
+        string variable = output.substr(findPos, findPos2 - findPos);
+        if (!variable.empty() && (variable.back() == '\r')) {
+            variable.pop_back();
+        }
+        const uint equalPos = variable.find('=');
+        if ((equalPos != string::npos) && (equalPos > 0)) {
+            m_msvcEnvironment.push_back(variable);
+        }
+        findPos = findPos2 + 1;
+    }
+    if (m_msvcEnvironment.empty()) {
+        outputError("Failed to retrieve the Visual Studio build environment");
+        return false;
+    }
+    return true;
+}
+
+bool ProjectGenerator::runMSVC(
+    const vector<string>& includeDirs, map<string, vector<string>>& directoryObjects)
+{
+    if (!findMSVCEnvironment()) {
+        return false;
+    }
+    // The include directories and defines are only written once and then shared by every compiler call
+    string tempFolder = m_tempDirectory + m_projectName;
+    const string responseFile = tempFolder + "/ffvs_compile.rsp";
+    string responseFileText;
+    buildCompilerResponseFile(includeDirs, responseFileText);
+    if (!writeToFile(responseFile, responseFileText)) {
+        outputError("Failed creating compiler response file (" + responseFile + ")");
+        return false;
+    }
+
+    // Files are split into batches so that there is a compiler call for each available core
+    uint numFiles = 0;
+    for (const auto& j : directoryObjects) {
+        numFiles += j.second.size();
+    }
+    const uint batchSize = getCompilerBatchSize(numFiles);
+    vector<ProcessJob> jobs;
+    vector<string> jobDirs;
+    for (auto& j : directoryObjects) {
+        string dirName = tempFolder + "/" + j.first;
+        // Need to make output directory so compile doesn't fail outputting
+        if (!makeDirectory(dirName)) {
+            outputError("Failed creating temporary directory (" + dirName + ")");
+            return false;
+        }
+        const string runCommands = "/FR\"" + dirName + "/\"" + " /Fo\"" + dirName + "/\"";
+        for (uint i = 0; i < j.second.size(); i += batchSize) {
+            // Each batch of files is passed through its own response file to prevent command line length limits
+            string batchFiles;
+            for (uint k = i; k < min<uint>(i + batchSize, j.second.size()); k++) {
+                m_configHelper.makeFileGeneratorRelative(j.second[k], j.second[k]);
+                batchFiles += '\"' + j.second[k] + "\"\n";
             }
-            findPos = testOutput.find("internal or external command");
-            if (findPos != string::npos) {
-                uint findPos2 = testOutput.find('\n', findPos + 1);
-                findPos = testOutput.rfind('\n', findPos);
-                findPos = (findPos == string::npos) ? 0 : findPos;
-                outputError(testOutput.substr(findPos, findPos2 - findPos), false);
-                missingVs = true;
+            const string batchFile = tempFolder + "/ffvs_batch_" + to_string(jobs.size()) + ".rsp";
+            if (!writeToFile(batchFile, batchFiles)) {
+                return false;
             }
-            if (missingVs) {
-                outputError(
-                    "Based on the above error(s) Visual Studio is not installed correctly on the host system.", false);
-                outputError("Install a compatible version of Visual Studio before trying again.", false);
-                deleteFile("ffvs_log.txt");
-            } else if (missingDeps) {
-                outputError(
-                    "Based on the above error(s) there are files required for dependency libraries that are not available",
-                    false);
-                outputError(
-                    "Ensure that any required dependencies are available in 'OutDir' based on the supplied configuration options before trying again.",
-                    false);
-                outputError("Consult the supplied readme for instructions for installing varying dependencies.", false);
-                outputError(
-                    "If a dependency has been cloned from a ShiftMediaProject repository then ensure it has been successfully built before trying again.",
-                    false);
-                outputError(
-                    "  Removing the offending configuration option can also be used to remove the error.", false);
-                deleteFile("ffvs_log.txt");
-            } else if (error) {
-                outputError("Unknown error detected. See ffvs_log.txt for further details.", false);
+            ProcessJob job;
+            job.command = getCompiler(0) + " @\"" + responseFile + "\" " + runCommands + " /c /w /nologo @\"" +
+                batchFile + '\"';
+            jobs.push_back(job);
+            jobDirs.push_back(j.first);
+        }
+    }
+
+    if (!runProcesses(jobs, m_msvcEnvironment)) {
+        outputError("Errors detected during compilation :-");
+        // Output errors from each of the failed batches
+        string log;
+        for (uint i = 0; i < jobs.size(); i++) {
+            if (!jobs[i].success) {
+                outputError("  Failed compiling files in (" + jobDirs[i] + ")", false);
+                log += jobs[i].output + jobs[i].errors;
             }
         }
+        if (writeToFile("ffvs_log.txt", log)) {
+            outputMSVCErrors();
+        }
         // Remove the compile files
-        deleteFile("ffvs_compile.bat");
         deleteFolder(m_tempDirectory);
         return false;
     }
-
-    // Remove the compilation objects
-    deleteFile("ffvs_compile.bat");
     return true;
 }
 
-bool ProjectGenerator::runGCC(
-    const vector<string>& includeDirs, map<string, vector<string>>& directoryObjects, int runType) const
+void ProjectGenerator::outputMSVCErrors()
 {
-    // Create a test file to read in definitions
-    string outDir = m_configHelper.m_outDirectory;
-    m_configHelper.makeFileGeneratorRelative(outDir, outDir);
-    vector<string> includeDirs2 = includeDirs;
-    includeDirs2.insert(includeDirs2.begin(), outDir + "include/");
-    includeDirs2.insert(includeDirs2.begin(), m_configHelper.m_solutionDirectory);
-    includeDirs2.insert(includeDirs2.begin(), m_configHelper.m_rootDirectory);
-    string extraCl;
-    for (auto& i : includeDirs2) {
-        uint uiFindPos2 = i.find("$(OutDir)");
-        if (uiFindPos2 != string::npos) {
-            i.replace(uiFindPos2, 9, outDir);
-        }
-        uiFindPos2 = i.find("$(");
-        if (uiFindPos2 != string::npos) {
-            i.replace(uiFindPos2, 2, "%");
-        }
-        uiFindPos2 = i.find(')');
-        if (uiFindPos2 != string::npos) {
-            i.replace(uiFindPos2, 1, "%");
+    string testOutput;
+    if (loadFromFile("ffvs_log.txt", testOutput)) {
+        // Output errors from ffvs_log.txt
+        bool error = false;
+        bool missingVs = false;
+        bool missingDeps = false;
+        uint findPos = testOutput.find(" error ");
+        while (findPos != string::npos) {
+            // find end of line
+            uint findPos2 = testOutput.find_first_of("\n(", findPos + 1);
+            string temp = testOutput.substr(findPos + 1, findPos2 - findPos - 1);
+            outputError(temp, false);
+            findPos = testOutput.find(" error ", findPos2 + 1);
+            // Check what type of error was found
+            if (!missingDeps && (temp.find("open include file") != string::npos)) {
+                missingDeps = true;
+            } else if (!missingVs && (temp.find("Visual Studio could not be detected") != string::npos)) {
+                missingVs = true;
+            } else {
+                error = true;
+            }
         }
-        if (i.length() == 0) {
-            i = "./";
-        } else if (i.find_first_of("./%") != 0) {
-            i = "./" + i;
+        findPos = testOutput.find("internal or external command");
+        if (findPos != string::npos) {
+            uint findPos2 = testOutput.find('\n', findPos + 1);
+            findPos = testOutput.rfind('\n', findPos);
+            findPos = (findPos == string::npos) ? 0 : findPos;
+            outputError(testOutput.substr(findPos, findPos2 - findPos), false);
+            missingVs = true;
+        }
+        if (missingVs) {
+            outputError(
+                "Based on the above error(s) Visual Studio is not installed correctly on the host system.", false);
+            outputError("Install a compatible version of Visual Studio before trying again.", false);
+            deleteFile("ffvs_log.txt");
+        } else if (missingDeps) {
+            outputError(
+                "Based on the above error(s) there are files required for dependency libraries that are not available",
+                false);
+            outputError(
+                "Ensure that any required dependencies are available in 'OutDir' based on the supplied configuration options before trying again.",
+                false);
+            outputError("Consult the supplied readme for instructions for installing varying dependencies.", false);
+            outputError(
+                "If a dependency has been cloned from a ShiftMediaProject repository then ensure it has been successfully built before trying again.",
+                false);
+            outputError(
+                "  Removing the offending configuration option can also be used to remove the error.", false);
+            deleteFile("ffvs_log.txt");
+        } else if (error) {
+            outputError("Unknown error detected. See ffvs_log.txt for further details.", false);
         }
-        extraCl += " /I\"" + i + '\"';
     }
-    string tempFolder = m_tempDirectory + m_projectName;
+}
 
-    // Use GNU compiler to pass the test file and retrieve declarations
-    string launchBat = "#!/bin/bash\n";
-    launchBat += "exitFail() {\n";
-    if (runType == 1) {
-        launchBat += "rm -rf *.i > /dev/null 2>&1\n";
+bool ProjectGenerator::runGCC(
+    const vector<string>& includeDirs, map<string, vector<string>>& directoryObjects)
+{
+    // The include directories and defines are only written once and then shared by every compiler call
+    string tempFolder = m_tempDirectory + m_projectName;
+    const string responseFile = tempFolder + "/ffvs_compile.rsp";
+    string responseFileText;
+    buildCompilerResponseFile(includeDirs, responseFileText);
+    if (!writeToFile(responseFile, responseFileText)) {
+        outputError("Failed creating compiler response file (" + responseFile + ")");
+        return false;
     }
-    launchBat += "rm -rf " + m_tempDirectory + " > /dev/null 2>&1\nexit 1\n}\n";
-    launchBat += "mkdir \"" + m_tempDirectory + "\" > /dev/null 2>&1\n";
-    launchBat += "mkdir \"" + tempFolder + "\" > /dev/null 2>&1\n";
+
+    // Split calls as gcc outputs a single file at a time
+    vector<ProcessJob> jobs;
+    vector<string> jobFiles;
     for (auto& i : directoryObjects) {
         string dirName = tempFolder + "/" + i.first;
-        if (i.first.length() > 0) {
-            // Need to make output directory so compile doesn't fail outputting
-            launchBat += "mkdir \"" + dirName + "\" > /dev/null 2>&1\n";
-        }
-        string runCommands;
-        // Check type of compiler call
-        if (runType == 0) {
-            outputError("Generation of definitions is not supported using gcc.");
+        // Need to make output directory so compile doesn't fail outputting
+        if (!makeDirectory(dirName)) {
+            outputError("Failed creating temporary directory (" + dirName + ")");
             return false;
         }
-        if (runType == 1) {
-            runCommands = "-E -P";
+        for (auto& j : i.second) {
+            m_configHelper.makeFileGeneratorRelative(j, j);
+            uint pos = j.rfind('/');
+            pos = (pos == string::npos) ? 0 : pos + 1;
+            ProcessJob job;
+            job.command = "gcc @\"" + responseFile + "\" -c -w \"" + j + "\" -o \"" + dirName + '/' +
+                j.substr(pos, j.rfind('.') - pos) + ".o\"";
+            jobs.push_back(job);
+            jobFiles.push_back(j);
+        }
+    }
+
+    if (!runProcesses(jobs)) {
+        outputError("Errors detected during compilation :-");
+        // Output errors from each of the failed files
+        for (uint i = 0; i < jobs.size(); i++) {
+            if (!jobs[i].success) {
+                outputError("  Failed compiling (" + jobFiles[i] + ")", false);
+                outputError(jobs[i].errors, false);
+            }
         }
-        // Check if gcc or mingw
-        if (m_configHelper.m_toolchain.find("mingw") != string::npos) {
-            extraCl += R"(-D"WIN32" -D"_WINDOWS")";
+        // Remove the compile files
+        deleteFolder(m_tempDirectory);
+        return false;
+    }
+    return true;
+}
+
+bool ProjectGenerator::outputPreProcessorBatches(const map<string, string>& sourceFiles, const string& folder,
+    vector<pair<string, StaticList>>& retBatches, map<string, string>& retWrappers)
+{
+    // Each source is written to a small wrapper file that sets the original file name for any output line markers
+    map<string, StaticList> directoryFiles;
+    uint fileID = 0;
+    for (const auto& i : sourceFiles) {
+        const string wrapperFile = folder + "/ffvs_" + to_string(fileID) + ".c";
+        if (!writeToFile(wrapperFile, "#line 1 \"" + i.first + "\"\n" + i.second + '\n')) {
+            return false;
         }
+        retWrappers[i.first] = wrapperFile;
+        // Quoted includes must still be found relative to the original source file
+        string sourceDir = i.first.substr(0, i.first.rfind('/') + 1);
+        sourceDir = (sourceDir.length() > 0) ? sourceDir : "./";
+        directoryFiles[sourceDir].push_back(i.first);
+        ++fileID;
+    }
 
-        // Split calls as gcc outputs a single file at a time
-        for (auto& j : i.second) {
-            launchBat += "gcc ";
-            launchBat += extraCl + " -D_DEBUG " + runCommands + " -c -w";
-            if (runType == 0) {
-                m_configHelper.makeFileGeneratorRelative(j, j);
+    // Files from the same source directory are split into batches so that there is a compiler call for each core
+    const uint batchSize = getCompilerBatchSize(sourceFiles.size());
+    for (const auto& i : directoryFiles) {
+        for (uint j = 0; j < i.second.size(); j += batchSize) {
+            string batchFiles;
+            StaticList batch;
+            for (uint k = j; k < min<uint>(j + batchSize, i.second.size()); k++) {
+                batchFiles += '\"' + retWrappers[i.second[k]] + "\"\n";
+                batch.push_back(i.second[k]);
             }
-            launchBat += " \"" + j + "\"";
-            if (runType == 0) {
-                launchBat += " -o " + j + ".o";
-            } else if (runType == 1) {
-                launchBat += " -o " + j + ".i";
+            // Each batch of files is passed through its own response file to prevent command line length limits
+            const string batchFile = folder + "/ffvs_batch_" + to_string(retBatches.size()) + ".rsp";
+            if (!writeToFile(batchFile, batchFiles)) {
+                return false;
             }
-            launchBat += " > ffvs_log.txt 2>&1\nif (( $? )); then\nexitFail\nfi\n";
+            retBatches.emplace_back(i.first, batch);
         }
     }
-    if (runType == 0) {
-        launchBat += "rm -rf *.o > /dev/null 2>&1\n";
+    return true;
+}
+
+bool ProjectGenerator::splitPreProcessorOutput(const string& output, const StaticList& batchFiles,
+    const map<string, string>& wrappers, map<string, string>& sourceFiles)
+{
+    // The output of each file starts with the line marker of its wrapper file (the path may use either separator)
+    vector<uint> starts;
+    uint pos = 0;
+    for (const auto& i : batchFiles) {
+        const string wrapper = wrappers.at(i);
+        const string search = wrapper.substr(wrapper.rfind('/') + 1) + '\"';
+        pos = output.find(search, pos);
+        while ((pos != string::npos) && (pos > 0) && (output.at(pos - 1) != '/') && (output.at(pos - 1) != '\\')) {
+            pos = output.find(search, pos + 1);
+        }
+        if (pos == string::npos) {
+            outputError("Failed to find pre-processed output for (" + i + ")");
+            return false;
+        }
+        pos = output.find_last_of(g_endLine, pos);
+        pos = (pos == string::npos) ? 0 : pos + 1;
+        starts.push_back(pos);
+    }
+    starts.push_back(output.length());
+    for (uint i = 0; i < batchFiles.size(); i++) {
+        sourceFiles[batchFiles[i]] = output.substr(starts[i], starts[i + 1] - starts[i]);
     }
-    launchBat += "rm ffvs_log.txt > /dev/null 2>&1\n";
-    launchBat += "exit 0\n";
-    if (!writeToFile("ffvs_compile.sh", launchBat)) {
+    return true;
+}
+
+bool ProjectGenerator::runPreProcessorMSVC(const string& responseFile, map<string, string>& sourceFiles)
+{
+    if (!findMSVCEnvironment()) {
         return false;
     }
-    if (0 != system("ffvs_compile.sh")) {
+    // The compiler can't read from stdin so each source is passed through a small wrapper file instead
+    const string tempFolder = m_tempDirectory + m_projectName;
+    vector<pair<string, StaticList>> batches;
+    map<string, string> wrappers;
+    if (!makeDirectory(tempFolder) || !writeToFile(tempFolder + "/ffvs_compile.rsp", responseFile) ||
+        !outputPreProcessorBatches(sourceFiles, tempFolder, batches, wrappers)) {
+        outputError("Failed creating pre-processor input files (" + tempFolder + ")");
+        deleteFolder(m_tempDirectory);
+        return false;
+    }
+    vector<ProcessJob> jobs;
+    for (uint i = 0; i < batches.size(); i++) {
+        // The source directory is searched after all other include directories
+        ProcessJob job;
+        job.command = getCompiler(1) + " @\"" + tempFolder + "/ffvs_compile.rsp\" /I\"" + batches[i].first +
+            "\" /E /w /nologo @\"" + tempFolder + "/ffvs_batch_" + to_string(i) + ".rsp\"";
+        jobs.push_back(job);
+    }
+
+    // The pre-processed output is read back directly from each compiler call
+    const bool ret = runProcesses(jobs, m_msvcEnvironment);
+    deleteFolder(m_tempDirectory);
+    if (!ret) {
         outputError("Errors detected during compilation :-");
-        outputError("Unknown error detected. See ffvs_log.txt for further details.", false);
-        // Remove the compilation files
-        deleteFile("ffvs_compile.sh");
+        // Output errors from each of the failed batches
+        string log;
+        for (uint i = 0; i < jobs.size(); i++) {
+            if (!jobs[i].success) {
+                outputError("  Failed pre-processing files from (" + batches[i].first + ")", false);
+                log += jobs[i].output + jobs[i].errors;
+            }
+        }
+        if (writeToFile("ffvs_log.txt", log)) {
+            outputMSVCErrors();
+        }
+        return false;
+    }
+    for (uint i = 0; i < jobs.size(); i++) {
+        if (!splitPreProcessorOutput(jobs[i].output, batches[i].second, wrappers, sourceFiles)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ProjectGenerator::runPreProcessorGCC(const string& responseFile, map<string, string>& sourceFiles)
+{
+    const string tempFolder = m_tempDirectory + m_projectName;
+    vector<pair<string, StaticList>> batches;
+    map<string, string> wrappers;
+    if (!makeDirectory(tempFolder) || !writeToFile(tempFolder + "/ffvs_compile.rsp", responseFile) ||
+        !outputPreProcessorBatches(sourceFiles, tempFolder, batches, wrappers)) {
+        outputError("Failed creating pre-processor input files (" + tempFolder + ")");
         deleteFolder(m_tempDirectory);
         return false;
     }
+    vector<ProcessJob> jobs;
+    for (uint i = 0; i < batches.size(); i++) {
+        ProcessJob job;
+        job.command = "gcc @\"" + tempFolder + "/ffvs_compile.rsp\" -iquote \"" + batches[i].first +
+            "\" -E -w -x c @\"" + tempFolder + "/ffvs_batch_" + to_string(i) + ".rsp\"";
+        jobs.push_back(job);
+    }
 
-    // Remove the compilation objects
-    deleteFile("ffvs_compile.sh");
+    // The pre-processed output is read back directly from each compiler call
+    const bool ret = runProcesses(jobs);
+    deleteFolder(m_tempDirectory);
+    if (!ret) {
+        outputError("Errors detected during compilation :-");
+        // Output errors from each of the failed batches
+        for (uint i = 0; i < jobs.size(); i++) {
+            if (!jobs[i].success) {
+                outputError("  Failed pre-processing files from (" + batches[i].first + ")", false);
+                outputError(jobs[i].errors, false);
+            }
+        }
+        return false;
+    }
+    for (uint i = 0; i < jobs.size(); i++) {
+        if (!splitPreProcessorOutput(jobs[i].output, batches[i].second, wrappers, sourceFiles)) {
+            return false;
+        }
+    }
     return true;
 }
+
+void ProjectGenerator::removePreProcessorLineMarkers(
+    const string& fileName, string& output, set<string>& retIncludes) const
+{
+    // Line markers are output as either '# 1 "file"' or '#line 1 "file"'
+    string retOutput;
+    retOutput.reserve(output.length());
+    uint findPos = 0;
+    while (findPos < output.length()) {
+        uint findPos2 = output.find('\n', findPos);
+        findPos2 = (findPos2 == string::npos) ? output.length() : findPos2 + 1;
+        uint pos = output.find_first_not_of(" \t", findPos);
+        bool lineMarker = false;
+        if ((pos < findPos2) && (output.at(pos) == '#')) {
+            pos = output.find_first_not_of(" \t", pos + 1);
+            if ((pos < findPos2) && (output.compare(pos, 4, "line") == 0)) {
+                pos = output.find_first_not_of(" \t", pos + 4);
+            }
+            if ((pos < findPos2) && isdigit(output.at(pos))) {
+                pos = output.find_first_not_of("0123456789", pos);
+                pos = output.find_first_not_of(" \t", pos);
+                lineMarker = (pos < findPos2) && (output.at(pos) == '"');
+            }
+        }
+        if (!lineMarker) {
+            retOutput.append(output, findPos, findPos2 - findPos);
+            findPos = findPos2;
+            continue;
+        }
+        // Get the file name removing any escaped characters
+        string include;
+        for (++pos; (pos < findPos2) && (output.at(pos) != '"'); ++pos) {
+            if ((output.at(pos) == '\\') && (pos + 1 < findPos2)) {
+                ++pos;
+            }
+            include += output.at(pos);
+        }
+        // Internal names and the generated input files are not real includes
+        replace(include.begin(), include.end(), '\\', '/');
+        if (!include.empty() && (include.at(0) != '<') && (include != fileName) &&
+            (include.find(m_tempDirectory) == string::npos)) {
+            retIncludes.insert(include);
+        }
+        retOutput += '\n';
+        findPos = findPos2;
+    }
+    output = move(retOutput);
+}
+
+string ProjectGenerator::getHash(const string& data)
+{
+    // 64bit FNV-1a hash
+    unsigned long long hash = 14695981039346656037ULL;
+    for (const auto& i : data) {
+        hash ^= static_cast<unsigned char>(i);
+        hash *= 1099511628211ULL;
+    }
+    const string hexChars = "0123456789abcdef";
+    string retHash(16, '0');
+    for (uint i = 0; i < 16; i++) {
+        retHash[15 - i] = hexChars[hash & 0xF];
+        hash >>= 4;
+    }
+    return retHash;
+}
+
+bool ProjectGenerator::getFileHash(const string& fileName, map<string, string>& fileHashes, string& retHash)
+{
+    const auto found = fileHashes.find(fileName);
+    if (found != fileHashes.end()) {
+        retHash = found->second;
+        return !retHash.empty();
+    }
+    string file;
+    retHash.clear();
+    if (loadFromFile(fileName, file, true, false)) {
+        retHash = getHash(file);
+    }
+    fileHashes[fileName] = retHash;
+    return !retHash.empty();
+}
+
+bool ProjectGenerator::findPreProcessorCache(
+    const string& key, map<string, string>& fileHashes, string& retOutput)
+{
+    string cacheFile;
+    if (!loadFromFile(m_configHelper.m_solutionDirectory + m_cacheDirectory + key, cacheFile, true, false)) {
+        return false;
+    }
+    // Each included file is listed with its hash on a separate line ending with an empty line
+    uint findPos = 0;
+    while (findPos < cacheFile.length()) {
+        const uint findPos2 = cacheFile.find('\n', findPos);
+        if (findPos2 == string::npos) {
+            return false;
+        }
+        if (findPos2 == findPos) {
+            retOutput = cacheFile.substr(findPos2 + 1);
+            m_cacheKeys.insert(key);
+            return true;
+        }
+        const uint hashEnd = cacheFile.find(' ', findPos);
+        if ((hashEnd == string::npos) || (hashEnd > findPos2)) {
+            return false;
+        }
+        // Check that the included file has not changed
+        string hash;
+        if (!getFileHash(cacheFile.substr(hashEnd + 1, findPos2 - hashEnd - 1), fileHashes, hash) ||
+            (cacheFile.compare(findPos, hashEnd - findPos, hash) != 0)) {
+            return false;
+        }
+        findPos = findPos2 + 1;
+    }
+    return false;
+}
+
+void ProjectGenerator::outputPreProcessorCache(
+    const string& key, const set<string>& includes, map<string, string>& fileHashes, const string& output)
+{
+    string cacheFile;
+    for (const auto& i : includes) {
+        string hash;
+        if (!getFileHash(i, fileHashes, hash)) {
+            // Results that depend on files that can't be checked are not cached
+            return;
+        }
+        cacheFile += hash + ' ' + i + '\n';
+    }
+    cacheFile += '\n' + output;
+    // The cache persists between runs so is not tracked as a generated output
+    if (writeToFile(m_configHelper.m_solutionDirectory + m_cacheDirectory + key, cacheFile, true, false)) {
+        m_cacheKeys.insert(key);
+    }
+}
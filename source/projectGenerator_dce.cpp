@@ -180,56 +180,16 @@ bool ProjectGenerator::outputProjectDCE(const StaticList& includeDirs)
     // Check if we failed to find any functions
     if (!foundDCEUsage.empty()) {
         vector<string> includeDirs2 = includeDirs;
-        string tempFolder = m_tempDirectory + m_projectName;
-        if (!makeDirectory(m_tempDirectory) || !makeDirectory(tempFolder)) {
-            outputError("Failed to create temporary working directory (" + tempFolder + ")");
-            return false;
-        }
         // Get all the files that include functions
         map<string, vector<DCEParams>> functionFiles;
-        // Remove project dir from start of file
-        string projectDirCut;
-        makePathsRelative(m_projectDir, m_configHelper.m_rootDirectory, projectDirCut);
-        projectDirCut = (projectDirCut.find('.') == 0) ? projectDirCut.substr(2) : projectDirCut;
         for (auto& i : foundDCEUsage) {
-            // Make source file relative to root
-            string file;
-            makePathsRelative(i.second.file, m_configHelper.m_rootDirectory, file);
-            file = (file.find('.') == 0) ? file.substr(2) : file;
-            uint pos = (projectDirCut.length() > 0) ? file.find(projectDirCut) : string::npos;
-            pos = (pos == string::npos) ? 0 : pos + projectDirCut.length();
-            file = tempFolder + '/' + file.substr(pos);
-            if (file.find('/', tempFolder.length() + 1) != string::npos) {
-                string sFolder = file.substr(0, file.rfind('/'));
-                if (!makeDirectory(sFolder)) {
-                    outputError("Failed to create temporary working sub-directory (" + sFolder + ")");
-                    return false;
-                }
-            }
-            // Copy file to local working directory
-            if (!copyFile(i.second.file, file)) {
-                outputError("Failed to copy dce file (" + i.second.file + ") to temporary directory (" + file + ")");
-                return false;
-            }
-            functionFiles[file].push_back({i.second.define, i.first});
+            functionFiles[i.second.file].push_back({i.second.define, i.first});
         }
-        map<string, vector<string>> directoryObjects;
+        map<string, string> sourceFiles;
         const string tags2[] = {"if (", "if(", "& ", "&", "| ", "|"};
         for (auto& i : functionFiles) {
-            // Get subdirectory
-            string subFolder;
-            if (i.first.find('/', tempFolder.length() + 1) != string::npos) {
-                subFolder = m_projectDir +
-                    i.first.substr(tempFolder.length() + 1, i.first.rfind('/') - tempFolder.length() - 1);
-                if (find(includeDirs2.begin(), includeDirs2.end(), subFolder) == includeDirs2.end()) {
-                    // Need to add subdirectory to include list
-                    includeDirs2.push_back(subFolder);
-                }
-                subFolder = subFolder.substr(m_projectDir.length());
-            }
-            directoryObjects[subFolder].push_back(i.first);
             // Modify existing tags so that they are still valid after preprocessing
-            string file;
+            string& file = sourceFiles[i.first];
             if (!loadFromFile(i.first, file)) {
                 return false;
             }
@@ -245,24 +205,18 @@ bool ProjectGenerator::outputProjectDCE(const StaticList& includeDirs)
                     }
                 }
             }
-            if (!writeToFile(i.first, file)) {
-                return false;
-            }
         }
         // Add current directory to include list (must be done last to ensure correct include order)
         if (find(includeDirs2.begin(), includeDirs2.end(), m_projectDir) == includeDirs2.end()) {
             includeDirs2.push_back(m_projectDir);
         }
-        if (!runCompiler(includeDirs2, directoryObjects, 1)) {
+        // The modified files are passed to the compiler from memory so no temporary copies are needed
+        if (!runPreProcessor(includeDirs2, sourceFiles)) {
             return false;
         }
         // Check the file that the function usage was found in to see if it was declared using macro expansion
         for (auto& i : functionFiles) {
-            string file = i.first;
-            file.at(file.length() - 1) = 'i';
-            if (!loadFromFile(file, file)) {
-                return false;
-            }
+            string& file = sourceFiles[i.first];
 
             // Restore the initial macro names
             for (const auto& j : g_tagsDCE) {
@@ -333,9 +287,6 @@ bool ProjectGenerator::outputProjectDCE(const StaticList& includeDirs)
                 }
             }
         }
-
-        // Delete the created temp files
-        deleteFolder(m_tempDirectory);
     }
 
     // Get any required hard coded values
@@ -396,23 +347,22 @@ bool ProjectGenerator::outputProjectDCE(const StaticList& includeDirs)
     // Add definition to new file
     if ((!foundDCEFunctions.empty()) || (!foundDCEVariables.empty())) {
         vector<DCEParams> includedHeaders;
-        string outFile;
+        // Stubs are grouped by their guard so that each distinct condition is only output once
+        map<string, string> outGroups;
         // Loop through all functions
         for (auto& i : foundDCEFunctions) {
             bool usePreProc = (i.second.define.length() > 1) && (i.second.define != "0");
-            if (usePreProc) {
-                outFile += "#if !(" + i.second.define + ")\n";
+            if (!usePreProc) {
+                i.second.define = "";
             }
+            string& outFile = outGroups[i.second.define];
             if (i.second.file.find(".h") != string::npos) {
                 // Include header files only once
-                if (!usePreProc) {
-                    i.second.define = "";
-                }
                 auto header = find(includedHeaders.begin(), includedHeaders.end(), i.second.file);
                 if (header == includedHeaders.end()) {
                     includedHeaders.push_back({i.second.define, i.second.file});
                 } else {
-                    outputProgramDCEsCombineDefine(header->define, i.second.define, header->define);
+                    outputProgramDCEsCombineDefine(header->define, i.second.define, header->define, true);
                 }
             }
             // Check to ensure the function correctly declares parameter names.
@@ -480,9 +430,6 @@ bool ProjectGenerator::outputProjectDCE(const StaticList& includeDirs)
                 outFile += "return *(" + return2 + "*)(0);";
             }
             outFile += "}\n";
-            if (usePreProc) {
-                outFile += "#endif\n";
-            }
         }
 
         // Loop through all variables
@@ -506,9 +453,7 @@ bool ProjectGenerator::outputProjectDCE(const StaticList& includeDirs)
             // Include only those options that are currently disabled
             if (!enabled) {
                 // Only include preprocessor guards if its a reserved option
-                if (usePreProc) {
-                    outFile += "#if !(" + i.second.define + ")\n";
-                } else {
+                if (!usePreProc) {
                     i.second.define = "";
                 }
                 // Include header files only once
@@ -516,12 +461,17 @@ bool ProjectGenerator::outputProjectDCE(const StaticList& includeDirs)
                 if (header == includedHeaders.end()) {
                     includedHeaders.push_back({i.second.define, i.second.file});
                 } else {
-                    outputProgramDCEsCombineDefine(header->define, i.second.define, header->define);
-                }
-                outFile += "const " + i.first + " = {0};\n";
-                if (usePreProc) {
-                    outFile += "#endif\n";
+                    outputProgramDCEsCombineDefine(header->define, i.second.define, header->define, true);
                 }
+                outGroups[i.second.define] += "const " + i.first + " = {0};\n";
+            }
+        }
+        string outFile;
+        for (const auto& i : outGroups) {
+            if (i.first.empty()) {
+                outFile += i.second;
+            } else {
+                outFile += "#if !(" + i.first + ")\n" + i.second + "#endif\n";
             }
         }
         string finalDCEOutFile = getCopywriteHeader(m_projectName + " DCE definitions") + '\n';
@@ -907,218 +857,261 @@ void ProjectGenerator::outputProjectDCEFindFunctions(const string& file, const s
 
 void ProjectGenerator::outputProgramDCEsResolveDefine(string& define)
 {
+    // The same conditions are found repeatedly so each distinct one is only resolved once
+    const auto found = m_resolvedDCEDefines.find(define);
+    if (found != m_resolvedDCEDefines.end()) {
+        define = found->second;
+        return;
+    }
+    string& resolved = m_resolvedDCEDefines[define];
+    DCECondition condition;
+    uint pos = 0;
+    if (!outputProgramDCEsParseDefine(define, pos, 0, condition) ||
+        (define.find_first_not_of(g_whiteSpace, pos) != string::npos)) {
+        // Leave any condition that cannot be understood for the pre-processor to handle
+        resolved = define;
+        return;
+    }
     // Complex combinations of config options require determining exact values
-    uint startTag = define.find_first_not_of(g_preProcessor);
-    while (startTag != string::npos) {
-        // Get the next tag
-        uint div = define.find_first_of(g_preProcessor, startTag);
-        string tag = define.substr(startTag, div - startTag);
-        // Check if tag is enabled
-        auto configOpt = m_configHelper.getConfigOptionPrefixed(tag);
-        if ((configOpt == m_configHelper.m_configValues.end()) ||
-            (m_configHelper.m_replaceList.find(configOpt->m_prefix + configOpt->m_option) !=
-                m_configHelper.m_replaceList.end())) {
-            // This config option doesn't exist but it is potentially included in its corresponding header file
-            // Or this is a reserved value
-        } else {
-            // Replace the option with its value
-            define.replace(startTag, div - startTag, configOpt->m_value);
-            div = define.find_first_of(g_preProcessor, startTag);
-        }
+    outputProgramDCEsReplaceTags(condition);
+    outputProgramDCEsSimplifyDefine(condition);
+    resolved = outputProgramDCEsPrintDefine(condition);
+    define = resolved;
+}
 
-        // Get next
-        startTag = define.find_first_not_of(g_preProcessor, div);
+bool ProjectGenerator::outputProgramDCEsParseDefine(
+    const string& define, uint& pos, const uint level, DCECondition& condition)
+{
+    pos = define.find_first_not_of(g_whiteSpace, pos);
+    if (pos == string::npos) {
+        return false;
     }
-    // Process the string to combine values
-    findAndReplace(define, "&&", "&");
-    findAndReplace(define, "||", "|");
-
-    // Need to search through for !, !=, ==, &&, || in correct order of precendence
-    const char ops[] = {'!', '=', '&', '|'};
-    for (char i : ops) {
-        startTag = define.find(i);
-        while (startTag != string::npos) {
-            // Check for != or ==
-            if (define.at(startTag + 1) == '=') {
-                ++startTag;
+    if (level >= 3) {
+        // Get unary operators or the next tag
+        if (define.at(pos) == '!') {
+            condition.type = DCECondition::Not;
+            condition.operands.resize(1);
+            ++pos;
+            return outputProgramDCEsParseDefine(define, pos, 3, condition.operands[0]);
+        }
+        if (define.at(pos) == '(') {
+            ++pos;
+            if (!outputProgramDCEsParseDefine(define, pos, 0, condition)) {
+                return false;
             }
-            // Get right tag
-            ++startTag;
-            uint rightPos = define.find_first_of(g_preProcessor, startTag);
-            // Skip any '(' found within the function parameters itself
-            if ((rightPos != string::npos) && (define.at(rightPos) == '(')) {
-                const uint back = rightPos + 1;
-                rightPos = define.find(')', back) + 1;
-                uint findPos3 = define.find('(', back);
-                while ((findPos3 != string::npos) && (findPos3 < rightPos)) {
-                    findPos3 = define.find('(', findPos3 + 1);
-                    rightPos = define.find(')', rightPos + 1) + 1;
+            pos = define.find_first_not_of(g_whiteSpace, pos);
+            if ((pos == string::npos) || (define.at(pos) != ')')) {
+                return false;
+            }
+            ++pos;
+            return true;
+        }
+        const uint end = define.find_first_of(g_preProcessor + g_whiteSpace, pos);
+        if (end == pos) {
+            return false;
+        }
+        condition.tag = define.substr(pos, end - pos);
+        condition.type = ((condition.tag == "0") || (condition.tag == "1")) ? DCECondition::Value : DCECondition::Tag;
+        pos = end;
+        uint next = define.find_first_not_of(g_whiteSpace, pos);
+        if ((condition.tag == "defined") && (next != string::npos) && (define.at(next) != '(')) {
+            // defined without brackets takes the following identifier as its parameter
+            const uint end2 = define.find_first_of(g_preProcessor + g_whiteSpace, next);
+            if (end2 == next) {
+                return false;
+            }
+            pos = (end2 == string::npos) ? define.length() : end2;
+            condition.tag += ' ' + define.substr(next, pos - next);
+        } else if ((next != string::npos) && (define.at(next) == '(')) {
+            // defined(X) and function-like macros are kept as a single opaque tag along with their parameters
+            uint depth = 0;
+            uint end2 = next;
+            for (; end2 < define.length(); ++end2) {
+                if (define.at(end2) == '(') {
+                    ++depth;
+                } else if ((define.at(end2) == ')') && (--depth == 0)) {
+                    break;
                 }
             }
-            string right = define.substr(startTag, rightPos - startTag);
-            --startTag;
+            if (end2 == define.length()) {
+                return false;
+            }
+            pos = end2 + 1;
+            condition.tag += define.substr(next, pos - next);
+        }
+        return true;
+    }
 
-            // Check current operation
-            if (define.at(startTag) == '!') {
-                if (right == "0") {
-                    //! 0 = 1
-                    define.replace(startTag, rightPos - startTag, 1, '1');
-                } else if (right == "1") {
-                    //! 1 = 0
-                    define.replace(startTag, rightPos - startTag, 1, '0');
-                } else {
-                    //! X = (!X)
-                    if (rightPos == string::npos) {
-                        define += ')';
-                    } else {
-                        define.insert(rightPos, 1, ')');
-                    }
-                    define.insert(startTag, 1, '(');
-                    startTag += 2;
-                }
-            } else {
-                // Check for != or ==
-                if (define.at(startTag) == '=') {
-                    --startTag;
-                }
-                // Get left tag
-                uint leftPos = define.find_last_of(g_preProcessor, startTag - 1);
-                // Skip any ')' found within the function parameters itself
-                if ((leftPos != string::npos) && (define.at(leftPos) == ')')) {
-                    const uint back = leftPos - 1;
-                    leftPos = define.rfind('(', back);
-                    uint findPos3 = define.rfind(')', back);
-                    while ((findPos3 != string::npos) && (findPos3 > leftPos)) {
-                        findPos3 = define.rfind(')', findPos3 - 1);
-                        leftPos = define.rfind('(', leftPos - 1);
-                    }
-                } else {
-                    leftPos = (leftPos == string::npos) ? 0 : leftPos + 1;
-                }
-                string left = define.substr(leftPos, startTag - leftPos);
+    // Get the left operand followed by any operators of the current precedence
+    if (!outputProgramDCEsParseDefine(define, pos, level + 1, condition)) {
+        return false;
+    }
+    uint next = define.find_first_not_of(g_whiteSpace, pos);
+    while (next != string::npos) {
+        DCECondition::Type type;
+        const char op = define.at(next);
+        const char op2 = (next + 1 < define.length()) ? define.at(next + 1) : '\0';
+        uint length = (op2 == op) ? 2 : 1;
+        if ((level == 0) && (op == '|')) {
+            type = DCECondition::Or;
+        } else if ((level == 1) && (op == '&')) {
+            type = DCECondition::And;
+        } else if ((level == 2) && ((op == '=') || (op == '!')) && (op2 == '=')) {
+            type = (op == '=') ? DCECondition::Equal : DCECondition::NotEqual;
+            length = 2;
+        } else {
+            break;
+        }
+        pos = next + length;
+        DCECondition right;
+        if (!outputProgramDCEsParseDefine(define, pos, level + 1, right)) {
+            return false;
+        }
+        if ((condition.type == type) && (type != DCECondition::Equal) && (type != DCECondition::NotEqual)) {
+            // && and || can be chained within the same node
+            condition.operands.push_back(move(right));
+        } else {
+            DCECondition left = move(condition);
+            condition.type = type;
+            condition.tag.clear();
+            condition.operands.clear();
+            condition.operands.push_back(move(left));
+            condition.operands.push_back(move(right));
+        }
+        next = define.find_first_not_of(g_whiteSpace, pos);
+    }
+    return true;
+}
 
-                // Check current operation
-                if (i == '&') {
-                    if ((left == "0") || (right == "0")) {
-                        // 0&&X or X&&0 == 0
-                        define.replace(leftPos, rightPos - leftPos, 1, '0');
-                        startTag = leftPos;
-                    } else if (left == "1") {
-                        // 1&&X = X
-                        ++startTag;
-                        define.erase(leftPos, startTag - leftPos);
-                        startTag = leftPos;
-                    } else if (right == "1") {
-                        // X&&1 = X
-                        define.erase(startTag, rightPos - startTag);
-                    } else {
-                        // X&&X = (X&&X)
-                        if (rightPos == string::npos) {
-                            define += ')';
-                        } else {
-                            define.insert(rightPos, 1, ')');
-                        }
-                        define.insert(leftPos, 1, '(');
-                        startTag += 2;
-                    }
-                } else if (i == '|') {
-                    if ((left == "1") || (right == "1")) {
-                        // 1||X or X||1 == 1
-                        define.replace(leftPos, rightPos - leftPos, 1, '1');
-                        startTag = leftPos;
-                    } else if (left == "0") {
-                        // 0||X = X
-                        ++startTag;
-                        define.erase(leftPos, startTag - leftPos);
-                        startTag = leftPos;
-                    } else if (right == "0") {
-                        // X||0 == X
-                        define.erase(startTag, rightPos - startTag);
-                    } else {
-                        // X||X = (X||X)
-                        if (rightPos == string::npos) {
-                            define += ')';
-                        } else {
-                            define.insert(rightPos, 1, ')');
-                        }
-                        define.insert(leftPos, 1, '(');
-                        startTag += 2;
-                    }
-                } else if (i == '!') {
-                    if ((left == "1") && (right == "1")) {
-                        // 1!=1 == 0
-                        define.replace(leftPos, rightPos - leftPos, 1, '0');
-                        startTag = leftPos;
-                    } else if ((left == "1") && (right == "0")) {
-                        // 1!=0 == 1
-                        define.replace(leftPos, rightPos - leftPos, 1, '1');
-                        startTag = leftPos;
-                    } else if ((left == "0") && (right == "1")) {
-                        // 0!=1 == 1
-                        define.replace(leftPos, rightPos - leftPos, 1, '1');
-                        startTag = leftPos;
-                    } else {
-                        // X!=X = (X!=X)
-                        if (rightPos == string::npos) {
-                            define += ')';
-                        } else {
-                            define.insert(rightPos, 1, ')');
-                        }
-                        define.insert(leftPos, 1, '(');
-                        startTag += 2;
-                    }
-                } else if (i == '=') {
-                    if ((left == "1") && (right == "1")) {
-                        // 1==1 == 1
-                        define.replace(leftPos, rightPos - leftPos, 1, '1');
-                        startTag = leftPos;
-                    } else if ((left == "1") && (right == "0")) {
-                        // 1==0 == 0
-                        define.replace(leftPos, rightPos - leftPos, 1, '0');
-                        startTag = leftPos;
-                    } else if ((left == "0") && (right == "1")) {
-                        // 0==1 == 0
-                        define.replace(leftPos, rightPos - leftPos, 1, '0');
-                        startTag = leftPos;
-                    } else {
-                        // X==X == (X==X)
-                        if (rightPos == string::npos) {
-                            define += ')';
-                        } else {
-                            define.insert(rightPos, 1, ')');
-                        }
-                        define.insert(leftPos, 1, '(');
-                        startTag += 2;
-                    }
+void ProjectGenerator::outputProgramDCEsReplaceTags(DCECondition& condition)
+{
+    if (condition.type == DCECondition::Tag) {
+        // Lookup each tag only once
+        auto tag = m_resolvedDCETags.find(condition.tag);
+        if (tag == m_resolvedDCETags.end()) {
+            string value;
+            auto configOpt = m_configHelper.getConfigOptionPrefixed(condition.tag);
+            if ((configOpt == m_configHelper.m_configValues.end()) ||
+                (m_configHelper.m_replaceList.find(configOpt->m_prefix + configOpt->m_option) !=
+                    m_configHelper.m_replaceList.end())) {
+                // This config option doesn't exist but it is potentially included in its corresponding header file
+                // Or this is a reserved value
+            } else if ((configOpt->m_value == "0") || (configOpt->m_value == "1")) {
+                value = configOpt->m_value;
+            }
+            tag = m_resolvedDCETags.emplace(condition.tag, value).first;
+        }
+        if (!tag->second.empty()) {
+            // Replace the option with its value
+            condition.type = DCECondition::Value;
+            condition.tag = tag->second;
+        }
+    } else {
+        for (auto& i : condition.operands) {
+            outputProgramDCEsReplaceTags(i);
+        }
+    }
+}
+
+void ProjectGenerator::outputProgramDCEsSimplifyDefine(DCECondition& condition)
+{
+    if (condition.type == DCECondition::Not) {
+        outputProgramDCEsSimplifyDefine(condition.operands[0]);
+        if (condition.operands[0].type == DCECondition::Value) {
+            //! 0 = 1, ! 1 = 0
+            condition.type = DCECondition::Value;
+            condition.tag = (condition.operands[0].tag == "1") ? "0" : "1";
+            condition.operands.clear();
+        } else if (condition.operands[0].type == DCECondition::Not) {
+            //!! X = X
+            DCECondition inner = move(condition.operands[0].operands[0]);
+            condition = move(inner);
+        }
+    } else if ((condition.type == DCECondition::And) || (condition.type == DCECondition::Or)) {
+        // 0&&X = 0, 1&&X = X, 1||X = 1, 0||X = X
+        const string absorb = (condition.type == DCECondition::And) ? "0" : "1";
+        vector<DCECondition> operands;
+        for (auto& i : condition.operands) {
+            outputProgramDCEsSimplifyDefine(i);
+            if (i.type == DCECondition::Value) {
+                if (i.tag == absorb) {
+                    operands.clear();
+                    operands.push_back(move(i));
+                    break;
                 }
+            } else if (i.type == condition.type) {
+                move(i.operands.begin(), i.operands.end(), back_inserter(operands));
+            } else {
+                operands.push_back(move(i));
             }
-            findAndReplace(define, "(0)", "0");
-            findAndReplace(define, "(1)", "1");
+        }
+        // Sort the operands and remove any duplicates so that equivalent conditions produce identical strings
+        map<string, DCECondition> sorted;
+        for (auto& i : operands) {
+            string key = outputProgramDCEsPrintDefine(i);
+            sorted.emplace(move(key), move(i));
+        }
+        operands.clear();
+        for (auto& i : sorted) {
+            operands.push_back(move(i.second));
+        }
+        if (operands.empty()) {
+            condition.type = DCECondition::Value;
+            condition.tag = (absorb == "0") ? "1" : "0";
+            condition.operands.clear();
+        } else if (operands.size() == 1) {
+            DCECondition inner = move(operands[0]);
+            condition = move(inner);
+        } else {
+            condition.operands = move(operands);
+        }
+    } else if ((condition.type == DCECondition::Equal) || (condition.type == DCECondition::NotEqual)) {
+        outputProgramDCEsSimplifyDefine(condition.operands[0]);
+        outputProgramDCEsSimplifyDefine(condition.operands[1]);
+        if ((condition.operands[0].type == DCECondition::Value) && (condition.operands[1].type == DCECondition::Value)) {
+            // 1==1 = 1, 1==0 = 0, 1!=1 = 0, 1!=0 = 1
+            const bool equal = (condition.operands[0].tag == condition.operands[1].tag);
+            condition.tag = (equal == (condition.type == DCECondition::Equal)) ? "1" : "0";
+            condition.type = DCECondition::Value;
+            condition.operands.clear();
+        }
+    }
+}
 
-            // Get next
-            startTag = define.find(i, startTag);
+string ProjectGenerator::outputProgramDCEsPrintDefine(const DCECondition& condition)
+{
+    if ((condition.type == DCECondition::Value) || (condition.type == DCECondition::Tag)) {
+        return condition.tag;
+    }
+    if (condition.type == DCECondition::Not) {
+        const DCECondition& operand = condition.operands[0];
+        if ((operand.type == DCECondition::Value) || (operand.type == DCECondition::Tag) ||
+            (operand.type == DCECondition::Not)) {
+            return '!' + outputProgramDCEsPrintDefine(operand);
         }
+        return "!(" + outputProgramDCEsPrintDefine(operand) + ')';
     }
-    // Remove any (RESERV)
-    startTag = define.find('(');
-    while (startTag != string::npos) {
-        uint endTag = define.find(')', startTag);
-        ++startTag;
-        // Skip any '(' found within the function parameters itself
-        uint findPos3 = define.find('(', startTag);
-        while ((findPos3 != string::npos) && (findPos3 < endTag)) {
-            findPos3 = define.find('(', findPos3 + 1);
-            endTag = define.find(')', endTag + 1);
+    string op = " != ";
+    if (condition.type == DCECondition::And) {
+        op = " && ";
+    } else if (condition.type == DCECondition::Or) {
+        op = " || ";
+    } else if (condition.type == DCECondition::Equal) {
+        op = " == ";
+    }
+    string ret;
+    for (const auto& i : condition.operands) {
+        if (!ret.empty()) {
+            ret += op;
         }
-        string tag = define.substr(startTag, endTag - startTag);
-        if ((tag.find_first_of("&|()") == string::npos) || ((startTag == 1) && (endTag == define.length() - 1))) {
-            define.erase(endTag, 1);
-            define.erase(--startTag, 1);
+        // Only bracket nested operators
+        if ((i.type == DCECondition::Value) || (i.type == DCECondition::Tag) || (i.type == DCECondition::Not)) {
+            ret += outputProgramDCEsPrintDefine(i);
+        } else {
+            ret += '(' + outputProgramDCEsPrintDefine(i) + ')';
         }
-        startTag = define.find('(', startTag);
     }
-    findAndReplace(define, "&", " && ");
-    findAndReplace(define, "|", " || ");
+    return ret;
 }
 
 bool ProjectGenerator::outputProjectDCEsFindDeclarations(
@@ -1318,32 +1311,36 @@ void ProjectGenerator::outputProjectDCECleanDefine(string& define)
     }
 }
 
-void ProjectGenerator::outputProgramDCEsCombineDefine(const string& define, const string& define2, string& retDefine)
+void ProjectGenerator::outputProgramDCEsCombineDefine(
+    const string& define, const string& define2, string& retDefine, const bool combineAll)
 {
-    if (define != define2) {
-        // Check if either string contains the other
-        if ((define.find(define2) != string::npos) || (define2.length() == 0)) {
-            // Keep the existing one
-            retDefine = define;
-        } else if ((define2.find(define) != string::npos) || (define.length() == 0)) {
-            // Use the new one in place of the original
-            retDefine = define2;
-        } else {
-            // Add the additional define
-            string ret = "||";
-            if (define.find('&') != string::npos) {
-                ret = '(' + define + ')' + ret;
-            } else {
-                ret = define + ret;
-            }
-            if (define2.find('&') != string::npos) {
-                ret += '(' + define2 + ')';
-            } else {
-                ret += define2;
-            }
-            retDefine = ret;
-        }
-    } else {
+    if (combineAll && (define.empty() || define2.empty())) {
+        // An empty define is unconditional so the combination is as well
+        retDefine.clear();
+        return;
+    }
+    if ((define == define2) || define2.empty()) {
         retDefine = define;
+        return;
+    }
+    if (define.empty()) {
+        retDefine = define2;
+        return;
+    }
+    // Combine the parsed conditions so that the result is in canonical form
+    DCECondition condition;
+    condition.type = (combineAll) ? DCECondition::And : DCECondition::Or;
+    condition.operands.resize(2);
+    uint pos = 0;
+    uint pos2 = 0;
+    if (outputProgramDCEsParseDefine(define, pos, 0, condition.operands[0]) &&
+        (define.find_first_not_of(g_whiteSpace, pos) == string::npos) &&
+        outputProgramDCEsParseDefine(define2, pos2, 0, condition.operands[1]) &&
+        (define2.find_first_not_of(g_whiteSpace, pos2) == string::npos)) {
+        outputProgramDCEsSimplifyDefine(condition);
+        retDefine = outputProgramDCEsPrintDefine(condition);
+    } else {
+        // Add the additional define
+        retDefine = '(' + define + ')' + ((combineAll) ? " && " : " || ") + '(' + define2 + ')';
     }
 }
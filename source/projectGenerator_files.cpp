@@ -21,8 +21,22 @@
 #include "projectGenerator.h"
 
 #include <algorithm>
+#include <functional>
 #include <utility>
 
+static bool hasCommonElement(const set<string>& set1, const set<string>& set2)
+{
+    // Search through the smaller set only
+    const set<string>& search = (set1.size() < set2.size()) ? set1 : set2;
+    const set<string>& other = (set1.size() < set2.size()) ? set2 : set1;
+    for (const auto& i : search) {
+        if (other.find(i) != other.end()) {
+            return true;
+        }
+    }
+    return false;
+}
+
 bool ProjectGenerator::findSourceFile(const string& file, const string& extension, string& retFileName) const
 {
     string fileName;
@@ -99,22 +113,23 @@ bool ProjectGenerator::checkProjectFiles()
     }
 
     // Check the output Unknown Includes and find there corresponding file
-    if (!findProjectFiles(m_includes, m_includesC, m_includesCPP, m_includesASM, m_includesH, m_includesCU)) {
+    if (!findProjectFiles(
+            m_includes, m_includesC, m_includesCPP, m_includesASM, m_includesGAS, m_includesH, m_includesCU)) {
         return false;
     }
 
-    if (m_configHelper.m_onlyDCE) {
+    if (m_configHelper.m_onlyDCE && !m_configHelper.m_useNinja) {
         // Don't need to check for replace files
         return true;
     }
 
     // Check all source files associated with replaced config values
-    StaticList replaceIncludes, replaceCPPIncludes, replaceCIncludes, replaceASMIncludes;
+    StaticList replaceIncludes, replaceCPPIncludes, replaceCIncludes, replaceASMIncludes, replaceGASIncludes;
     for (auto& include : m_replaceIncludes) {
         replaceIncludes.push_back(include.first);
     }
-    if (!findProjectFiles(
-            replaceIncludes, replaceCIncludes, replaceCPPIncludes, replaceASMIncludes, m_includesH, m_includesCU)) {
+    if (!findProjectFiles(replaceIncludes, replaceCIncludes, replaceCPPIncludes, replaceASMIncludes,
+            replaceGASIncludes, m_includesH, m_includesCU)) {
         return false;
     }
     // Need to create local files for any replace objects
@@ -127,6 +142,9 @@ bool ProjectGenerator::checkProjectFiles()
     if (!createReplaceFiles(replaceASMIncludes, m_includesASM)) {
         return false;
     }
+    if (!createReplaceFiles(replaceGASIncludes, m_includesGAS)) {
+        return false;
+    }
     return true;
 }
 
@@ -198,8 +216,834 @@ bool ProjectGenerator::createReplaceFiles(const StaticList& replaceIncludes, Sta
     return true;
 }
 
+bool ProjectGenerator::createUnityFiles(StaticList& unityFiles, StaticList& unityIncludes)
+{
+    if (m_configHelper.m_unitySize < 2) {
+        return true;
+    }
+
+    // Group the source files by directory
+    map<string, StaticList> directories;
+    for (const auto& i : m_includesC) {
+        // Generated files, files with custom settings and any user excluded files are kept out of unity files
+        const string fileName = i.substr(i.rfind('/') + 1);
+        bool exclude = (fileName == "dce_defs.c") || (m_sourceFileSettings.find(i) != m_sourceFileSettings.end()) ||
+            ((fileName.length() > 7) && (fileName.compare(fileName.length() - 7, 7, "_wrap.c") == 0));
+        for (const auto& j : m_configHelper.m_unityExcludes) {
+            if ((i.length() >= j.length()) && (i.compare(i.length() - j.length(), j.length(), j) == 0) &&
+                ((i.length() == j.length()) || (i.at(i.length() - j.length() - 1) == '/'))) {
+                exclude = true;
+                break;
+            }
+        }
+        if (!exclude) {
+            directories[i.substr(0, i.rfind('/') + 1)].push_back(i);
+        }
+    }
+
+    for (const auto& i : directories) {
+        // Add each file to the first unity file that it does not conflict with
+        vector<UnitySymbols> units;
+        vector<StaticList> unitFiles;
+        for (const auto& j : i.second) {
+            string file;
+            if (!loadFromFile(m_configHelper.m_solutionDirectory + j, file)) {
+                return false;
+            }
+            string code;
+            removeComments(file, code);
+            UnitySymbols symbols;
+            findUnitySymbols(code, symbols);
+            if (symbols.standalone) {
+                continue;
+            }
+            // Files with the same object name are likely to share the same static symbols
+            string objectName = j.substr(j.rfind('/') + 1);
+            objectName.resize(objectName.rfind('.'));
+            symbols.objects.insert(objectName);
+            uint unit = 0;
+            for (; unit < units.size(); unit++) {
+                if ((unitFiles[unit].size() < m_configHelper.m_unitySize) &&
+                    !hasCommonElement(units[unit].objects, symbols.objects) &&
+                    !hasCommonElement(units[unit].declared, symbols.declared) &&
+                    !hasCommonElement(units[unit].macros, symbols.identifiers)) {
+                    break;
+                }
+            }
+            if (unit == units.size()) {
+                units.emplace_back();
+                unitFiles.emplace_back();
+            }
+            units[unit].objects.insert(symbols.objects.begin(), symbols.objects.end());
+            units[unit].declared.insert(symbols.declared.begin(), symbols.declared.end());
+            units[unit].identifiers.insert(symbols.identifiers.begin(), symbols.identifiers.end());
+            units[unit].macros.insert(symbols.macros.begin(), symbols.macros.end());
+            unitFiles[unit].push_back(j);
+        }
+
+        // Get the directory name without any leading relative path
+        string directory = i.first;
+        while ((directory.find("../") == 0) || (directory.find("./") == 0)) {
+            directory.erase(0, directory.find('/') + 1);
+        }
+        replace(directory.begin(), directory.end(), '/', '_');
+
+        // Output each unity file that combines more than a single file
+        uint index = 0;
+        for (const auto& j : unitFiles) {
+            if (j.size() < 2) {
+                continue;
+            }
+            string unityFile = getCopywriteHeader("unity build file for " + m_projectName) + '\n';
+            for (const auto& k : j) {
+                unityFile += "\n#include \"../" + k + '"';
+                unityIncludes.push_back(k);
+            }
+            unityFile += '\n';
+            const string outFile =
+                m_configHelper.m_solutionDirectory + m_projectName + "/unity_" + directory + to_string(index) + ".c";
+            if (!writeToFile(outFile, unityFile)) {
+                return false;
+            }
+            string newOutFile;
+            m_configHelper.makeFileProjectRelative(outFile, newOutFile);
+            unityFiles.push_back(newOutFile);
+            ++index;
+        }
+    }
+    return true;
+}
+
+bool ProjectGenerator::createPrecompiledHeader(TemplateSlots& slots)
+{
+    if (!m_configHelper.m_usePCH) {
+        return true;
+    }
+
+    // Count the stable headers that are unconditionally included by each compatible source file
+    map<string, uint> includeCounts;
+    StaticList incompatible;
+    uint compatible = 0;
+    for (const auto& i : m_includesC) {
+        const string fileName = i.substr(i.rfind('/') + 1);
+        if ((fileName.length() > 7) && (fileName.compare(fileName.length() - 7, 7, "_wrap.c") == 0)) {
+            incompatible.push_back(i);
+            continue;
+        }
+        string file;
+        if (!loadFromFile(m_configHelper.m_solutionDirectory + i, file)) {
+            return false;
+        }
+        string code;
+        removeComments(file, code);
+        UnitySymbols symbols;
+        findUnitySymbols(code, symbols);
+        if (symbols.standalone) {
+            incompatible.push_back(i);
+            continue;
+        }
+        ++compatible;
+        set<string> found;
+        for (const auto& j : symbols.includes) {
+            if (((j == "\"config.h\"") || (j.find('<') == 0) || (j.find("\"libavutil/") == 0)) &&
+                found.insert(j).second) {
+                ++includeCounts[j];
+            }
+        }
+    }
+
+    // Small projects gain little from a precompiled header
+    const uint minFiles = 4;
+    if (compatible < minFiles) {
+        return true;
+    }
+
+    // Use any header included by at least half of the compatible files
+    string rootDir;
+    m_configHelper.makeFileProjectRelative(m_configHelper.m_rootDirectory, rootDir);
+    if (!rootDir.empty() && (rootDir.back() != '/')) {
+        rootDir += '/';
+    }
+    multimap<uint, string, greater<uint>> systemHeaders;
+    multimap<uint, string, greater<uint>> localHeaders;
+    bool config = false;
+    for (const auto& i : includeCounts) {
+        if (i.second * 2 < compatible) {
+            continue;
+        }
+        if (i.first == "\"config.h\"") {
+            config = true;
+        } else if (i.first.at(0) == '<') {
+            systemHeaders.emplace(i.second, i.first);
+        } else {
+            // Component options are only forced included after the precompiled header so any header using them is left
+            // out (otherwise they would be precompiled as disabled)
+            if (!m_configHelper.m_componentConfigs.empty()) {
+                const string header = i.first.substr(1, i.first.length() - 2);
+                string fileName;
+                if (findFile(m_configHelper.m_solutionDirectory + header, fileName)) {
+                    fileName = header;
+                } else if (findFile(m_configHelper.m_solutionDirectory + rootDir + header, fileName)) {
+                    fileName = rootDir + header;
+                } else {
+                    continue;
+                }
+                bool components;
+                if (!findComponentUsage(fileName, components)) {
+                    return false;
+                }
+                if (components) {
+                    continue;
+                }
+            }
+            localHeaders.emplace(i.second, i.first);
+        }
+    }
+    if (!config && systemHeaders.empty() && localHeaders.empty()) {
+        return true;
+    }
+
+    // Output the header with config.h first followed by system headers and then the most used headers
+    string headerFile = getCopywriteHeader("precompiled header for " + m_projectName) + '\n';
+    if (config) {
+        headerFile += "\n#include \"config.h\"";
+    }
+    for (const auto& i : systemHeaders) {
+        headerFile += "\n#include " + i.second;
+    }
+    for (const auto& i : localHeaders) {
+        headerFile += "\n#include " + i.second;
+    }
+    headerFile += '\n';
+    const string outDir = m_configHelper.m_solutionDirectory + m_projectName + '/';
+    if (!writeToFile(outDir + "pch.h", headerFile)) {
+        return false;
+    }
+
+    // The header is created by compiling an empty stub as it is already forced included
+    const string stubFile = getCopywriteHeader("precompiled header stub for " + m_projectName) + '\n';
+    if (!writeToFile(outDir + "pch.c", stubFile)) {
+        return false;
+    }
+    string newOutFile;
+    m_configHelper.makeFileProjectRelative(outDir + "pch.c", newOutFile);
+    m_includesC.push_back(newOutFile);
+
+    // Set the per file settings for the stub and any incompatible files
+    const string pchSetting = "\r\n      <PrecompiledHeader>";
+    const string pchSettingEnd = "</PrecompiledHeader>";
+    const string notUsing =
+        pchSetting + "NotUsing" + pchSettingEnd + "\r\n      <ForcedIncludeFiles>compat.h</ForcedIncludeFiles>";
+    m_sourceFileSettings[newOutFile] = pchSetting + "Create" + pchSettingEnd;
+    for (const auto& i : incompatible) {
+        m_sourceFileSettings[i] = notUsing;
+    }
+    for (const auto& i : m_includesCPP) {
+        m_sourceFileSettings[i] = notUsing;
+    }
+
+    // Add the project settings to the template
+    const string header = m_projectName + "\\pch.h";
+    slots["precompiledHeader"].push_back(pchSetting + "Use" + pchSettingEnd +
+        "\r\n      <PrecompiledHeaderFile>" + header + "</PrecompiledHeaderFile>");
+    slots["precompiledHeaderDisabled"].push_back("");
+    slots["forcedIncludes"].push_back(header + ';');
+    return true;
+}
+
+static bool matchWildcard(const string& pattern, const string& text)
+{
+    // Match '*' against any sequence (including directory separators) and '?' against any single character
+    uint patternPos = 0;
+    uint textPos = 0;
+    uint starPos = string::npos;
+    uint starMatch = 0;
+    while (textPos < text.length()) {
+        if ((patternPos < pattern.length()) &&
+            ((pattern.at(patternPos) == '?') || (pattern.at(patternPos) == text.at(textPos)))) {
+            ++patternPos;
+            ++textPos;
+        } else if ((patternPos < pattern.length()) && (pattern.at(patternPos) == '*')) {
+            starPos = patternPos++;
+            starMatch = textPos;
+        } else if (starPos != string::npos) {
+            // Backtrack and let the last '*' consume another character
+            patternPos = starPos + 1;
+            textPos = ++starMatch;
+        } else {
+            return false;
+        }
+    }
+    while ((patternPos < pattern.length()) && (pattern.at(patternPos) == '*')) {
+        ++patternPos;
+    }
+    return patternPos == pattern.length();
+}
+
+bool ProjectGenerator::loadFileSettings()
+{
+    string settingsFile;
+    if (!loadFromFile(m_configHelper.m_fileSettings, settingsFile)) {
+        return false;
+    }
+    m_fileSettings.clear();
+    uint lineNumber = 0;
+    uint startPos = 0;
+    while (startPos < settingsFile.length()) {
+        uint endPos = settingsFile.find('\n', startPos);
+        endPos = (endPos == string::npos) ? settingsFile.length() : endPos;
+        string line = settingsFile.substr(startPos, endPos - startPos);
+        startPos = endPos + 1;
+        ++lineNumber;
+        // Remove any comments and surrounding white space
+        const uint commentPos = line.find('#');
+        if (commentPos != string::npos) {
+            line.resize(commentPos);
+        }
+        const uint lineStart = line.find_first_not_of(" \t\r");
+        if (lineStart == string::npos) {
+            continue;
+        }
+        line = line.substr(lineStart, line.find_last_not_of(" \t\r") - lineStart + 1);
+
+        // Get the file pattern followed by the optional configurations
+        FileSetting setting;
+        uint pos = line.find_first_of(" \t");
+        setting.pattern = line.substr(0, pos);
+        replace(setting.pattern.begin(), setting.pattern.end(), '\\', '/');
+        pos = line.find_first_not_of(" \t", pos);
+        if (pos != string::npos) {
+            uint pos2 = line.find_first_of(" \t", pos);
+            pos2 = (pos2 == string::npos) ? line.length() : pos2;
+            if (line.at(pos2 - 1) == ':') {
+                const string configs = line.substr(pos, pos2 - pos - 1);
+                uint configStart = 0;
+                while (configStart < configs.length()) {
+                    uint configEnd = configs.find(',', configStart);
+                    configEnd = (configEnd == string::npos) ? configs.length() : configEnd;
+                    if (configEnd > configStart) {
+                        setting.configurations.push_back(configs.substr(configStart, configEnd - configStart));
+                    }
+                    configStart = configEnd + 1;
+                }
+                pos = line.find_first_not_of(" \t", pos2);
+            }
+        }
+        if (pos == string::npos) {
+            outputError("Missing compiler flags in file settings (" + m_configHelper.m_fileSettings + ':' +
+                to_string(lineNumber) + ')');
+            return false;
+        }
+        setting.flags = line.substr(pos);
+        m_fileSettings.push_back(setting);
+    }
+    return true;
+}
+
+static string getFileSettingsName(const string& fileName, const string& rootDir)
+{
+    // Rules are matched against the file name relative to the source root
+    string name = fileName;
+    replace(name.begin(), name.end(), '\\', '/');
+    if (!rootDir.empty() && (name.find(rootDir) == 0)) {
+        name = name.substr(rootDir.length());
+    }
+    return name;
+}
+
+/** List of compiler switches and the corresponding ClCompile item metadata name and value. */
+static const map<string, pair<string, string>> s_clMetadata = {
+    {"Od", {"Optimization", "Disabled"}},
+    {"O1", {"Optimization", "MinSpace"}},
+    {"O2", {"Optimization", "MaxSpeed"}},
+    {"Ox", {"Optimization", "Full"}},
+    {"Ob0", {"InlineFunctionExpansion", "Disabled"}},
+    {"Ob1", {"InlineFunctionExpansion", "OnlyExplicitInline"}},
+    {"Ob2", {"InlineFunctionExpansion", "AnySuitable"}},
+    {"Ob3", {"InlineFunctionExpansion", "Default"}},
+    {"Os", {"FavorSizeOrSpeed", "Size"}},
+    {"Ot", {"FavorSizeOrSpeed", "Speed"}},
+    {"Oi", {"IntrinsicFunctions", "true"}},
+    {"Oi-", {"IntrinsicFunctions", "false"}},
+    {"Oy", {"OmitFramePointers", "true"}},
+    {"Oy-", {"OmitFramePointers", "false"}},
+    {"GL", {"WholeProgramOptimization", "true"}},
+    {"GL-", {"WholeProgramOptimization", "false"}},
+};
+
+string ProjectGenerator::getFileSettingsMSVC(const string& fileName) const
+{
+    StaticList buildConfigs;
+    getBuildConfigurations(true, true, buildConfigs);
+    string rootDir;
+    m_configHelper.makeFileProjectRelative(m_configHelper.m_rootDirectory, rootDir);
+    const string name = getFileSettingsName(fileName, rootDir);
+    string ret;
+    for (const auto& i : m_fileSettings) {
+        if (!matchWildcard(i.pattern, name)) {
+            continue;
+        }
+        // Build the condition from all configurations that match any of the configuration patterns
+        string condition;
+        if (!i.configurations.empty()) {
+            for (const auto& j : buildConfigs) {
+                for (const auto& k : i.configurations) {
+                    if (matchWildcard(k, j)) {
+                        condition += condition.empty() ? " Condition=\"" : " Or ";
+                        condition += "'$(Configuration)'=='" + j + '\'';
+                        break;
+                    }
+                }
+            }
+            if (condition.empty()) {
+                // Only applies to the ninja build
+                continue;
+            }
+            condition += '"';
+        }
+        // Switches that have item metadata must use it so that they replace the projects default values
+        string options;
+        uint pos = i.flags.find_first_not_of(" \t");
+        while (pos != string::npos) {
+            // Quoted arguments may contain spaces
+            uint pos2 = pos;
+            bool quoted = false;
+            while ((pos2 < i.flags.length()) && (quoted || ((i.flags.at(pos2) != ' ') && (i.flags.at(pos2) != '\t')))) {
+                quoted = (i.flags.at(pos2) == '"') ? !quoted : quoted;
+                ++pos2;
+            }
+            const string option = i.flags.substr(pos, pos2 - pos);
+            const auto found = ((option.at(0) == '/') || (option.at(0) == '-')) ?
+                s_clMetadata.find(option.substr(1)) :
+                s_clMetadata.end();
+            if (found != s_clMetadata.end()) {
+                ret += "\r\n      <" + found->second.first + condition + '>' + found->second.second + "</" +
+                    found->second.first + '>';
+            }
+            if ((found == s_clMetadata.end()) || (found->first == "Ob3")) {
+                // There is no metadata value for /Ob3 so it is passed directly after disabling the default value
+                options += (options.empty() ? "" : " ") + option;
+            }
+            pos = i.flags.find_first_not_of(" \t", pos2);
+        }
+        if (!options.empty()) {
+            ret += "\r\n      <AdditionalOptions" + condition + '>' + options +
+                " %(AdditionalOptions)</AdditionalOptions>";
+        }
+    }
+    return ret;
+}
+
+string ProjectGenerator::getFileSettingsNinja(const string& fileName) const
+{
+    string rootDir;
+    m_configHelper.makeFileProjectRelative(m_configHelper.m_rootDirectory, rootDir);
+    const string name = getFileSettingsName(fileName, rootDir);
+    string ret;
+    for (const auto& i : m_fileSettings) {
+        // Compiler flags are not compatible with msvc so ninja rules must be explicitly requested
+        if (find(i.configurations.begin(), i.configurations.end(), "ninja") != i.configurations.end() &&
+            matchWildcard(i.pattern, name)) {
+            ret += (ret.empty() ? "" : " ") + i.flags;
+        }
+    }
+    return ret;
+}
+
+bool ProjectGenerator::findASMIncludes(const string& fileName, StaticList& retIncludes) const
+{
+    string file;
+    if (!loadFromFile(m_configHelper.m_solutionDirectory + fileName, file)) {
+        return false;
+    }
+    // Includes are searched for in the same directories that are passed to the assembler
+    string rootDir;
+    m_configHelper.makeFileProjectRelative(m_configHelper.m_rootDirectory, rootDir);
+    if (!rootDir.empty() && (rootDir.back() != '/')) {
+        rootDir += '/';
+    }
+    const string searchDirs[] = {
+        fileName.substr(0, fileName.rfind('/') + 1), "", rootDir, rootDir + getLibraryName() + "/x86/"};
+    const string search = "%include";
+    uint findPos = file.find(search);
+    while (findPos != string::npos) {
+        // Only includes at the start of a line are used
+        const uint lineStart = file.find_last_of(g_endLine, findPos) + 1;
+        findPos += search.length();
+        if (file.find_first_not_of(" \t", lineStart) != findPos - search.length()) {
+            findPos = file.find(search, findPos);
+            continue;
+        }
+        const uint nameStart = file.find_first_of("\"'<", findPos);
+        const uint nameEnd = file.find_first_of("\"'>", nameStart + 1);
+        if ((nameStart == string::npos) || (nameEnd == string::npos) ||
+            (file.find_first_of(g_endLine, findPos) < nameEnd)) {
+            findPos = file.find(search, findPos);
+            continue;
+        }
+        const string include = file.substr(nameStart + 1, nameEnd - nameStart - 1);
+        for (const auto& i : searchDirs) {
+            string includeFile = i + include;
+            string found;
+            if (findFile(m_configHelper.m_solutionDirectory + includeFile, found)) {
+                // Remove any redundant directory changes
+                uint pos;
+                while ((pos = includeFile.find("/./")) != string::npos) {
+                    includeFile.erase(pos, 2);
+                }
+                if (find(retIncludes.begin(), retIncludes.end(), includeFile) == retIncludes.end()) {
+                    retIncludes.push_back(includeFile);
+                    // Check for any nested includes
+                    if (!findASMIncludes(includeFile, retIncludes)) {
+                        return false;
+                    }
+                }
+                break;
+            }
+        }
+        findPos = file.find(search, nameEnd);
+    }
+    return true;
+}
+
+bool ProjectGenerator::findComponentUsage(const string& fileName, bool& retUsage)
+{
+    string rootDir;
+    m_configHelper.makeFileProjectRelative(m_configHelper.m_rootDirectory, rootDir);
+    if (!rootDir.empty() && (rootDir.back() != '/')) {
+        rootDir += '/';
+    }
+    const string nameChars = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_";
+    const string search = "CONFIG_";
+    const string include = "#include \"";
+
+    // Check the file and everything that it includes
+    retUsage = false;
+    set<string> checked;
+    StaticList files = {fileName};
+    while (!files.empty()) {
+        // Remove any redundant directory changes so that each file is only checked once
+        string file = files.back();
+        files.pop_back();
+        uint pos;
+        while ((pos = file.find("/./")) != string::npos) {
+            file.erase(pos, 2);
+        }
+        pos = file.find("/../");
+        while (pos != string::npos) {
+            const uint start = (pos == 0) ? string::npos : file.rfind('/', pos - 1);
+            const string directory = file.substr(start + 1, pos - start - 1);
+            if ((directory != "..") && (directory != ".")) {
+                file.erase(start + 1, pos + 4 - (start + 1));
+                pos = file.find("/../");
+            } else {
+                pos = file.find("/../", pos + 1);
+            }
+        }
+        if (!checked.insert(file).second) {
+            continue;
+        }
+
+        // Each file is only loaded once and the results are reused by any other file that includes it
+        auto found = m_componentFiles.find(file);
+        if (found == m_componentFiles.end()) {
+            string code;
+            if (!loadFromFile(m_configHelper.m_solutionDirectory + file, code)) {
+                return false;
+            }
+            ComponentUsage usage;
+            // Check for any component options
+            uint findPos = code.find(search);
+            while (findPos != string::npos) {
+                if ((findPos == 0) || (nameChars.find(code.at(findPos - 1)) == string::npos)) {
+                    const uint end = code.find_first_not_of(nameChars, findPos);
+                    const auto& components = m_configHelper.m_componentConfigs;
+                    if (components.find(code.substr(findPos, end - findPos)) != components.end()) {
+                        usage.uses = true;
+                        break;
+                    }
+                }
+                findPos = code.find(search, findPos + search.length());
+            }
+            // Find any included files using the same search order as the compiler
+            const string searchDirs[] = {file.substr(0, file.rfind('/') + 1), "", rootDir};
+            findPos = code.find(include);
+            while (!usage.uses && (findPos != string::npos)) {
+                findPos += include.length();
+                const uint end = code.find('"', findPos);
+                if (end == string::npos) {
+                    break;
+                }
+                const string includeFile = code.substr(findPos, end - findPos);
+                for (const auto& i : searchDirs) {
+                    string retFileName;
+                    if (findFile(m_configHelper.m_solutionDirectory + i + includeFile, retFileName)) {
+                        usage.includes.push_back(i + includeFile);
+                        break;
+                    }
+                }
+                findPos = code.find(include, end);
+            }
+            found = m_componentFiles.emplace(file, usage).first;
+        }
+        if (found->second.uses) {
+            retUsage = true;
+            return true;
+        }
+        files.insert(files.end(), found->second.includes.begin(), found->second.includes.end());
+    }
+    return true;
+}
+
+void ProjectGenerator::findUnitySymbols(const string& code, UnitySymbols& symbols)
+{
+    const string nameChars = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_";
+    // Split the code into identifiers and single punctuation characters
+    StaticList statement;
+    string previous;
+    uint depth = 0;
+    bool enumBody = false;
+    bool defined = false;
+    bool lineStart = true;
+    uint conditionals = 0;
+    uint pos = 0;
+    while (pos < code.length()) {
+        const char c = code.at(pos);
+        if (c == '\n') {
+            lineStart = true;
+            ++pos;
+            continue;
+        }
+        if (g_whiteSpace.find(c) != string::npos) {
+            ++pos;
+            continue;
+        }
+        if (lineStart && (c == '#')) {
+            // Get the pre-processor directive and its value
+            uint end = code.find('\n', pos);
+            end = (end == string::npos) ? code.length() : end;
+            const uint dirStart = code.find_first_not_of(g_whiteSpace, pos + 1);
+            const uint dirEnd = min<uint>(code.find_first_not_of(nameChars, dirStart), end);
+            const string directive = code.substr(dirStart, dirEnd - dirStart);
+            const uint nameStart = min<uint>(code.find_first_not_of(g_whiteSpace, dirEnd), end);
+            const uint nameEnd = min<uint>(code.find_first_not_of(nameChars, nameStart), end);
+            const string name = code.substr(nameStart, nameEnd - nameStart);
+            if (directive == "define") {
+                symbols.macros.insert(name);
+                defined = true;
+            } else if (directive == "undef") {
+                symbols.macros.erase(name);
+            } else if (directive.find("if") == 0) {
+                ++conditionals;
+            } else if ((directive == "endif") && (conditionals > 0)) {
+                --conditionals;
+            } else if (directive == "include") {
+                const uint includeEnd = code.find_last_not_of(g_whiteSpace, end - 1) + 1;
+                const string include = code.substr(nameStart, max<uint>(includeEnd, nameStart) - nameStart);
+                if (conditionals == 0) {
+                    symbols.includes.push_back(include);
+                }
+                // Macros defined before an include may change the behaviour of headers that are include guarded
+                if (defined && (include.find("template") == string::npos) &&
+                    (include.find(".c\"") == string::npos)) {
+                    symbols.standalone = true;
+                }
+            }
+            // Any identifiers used by the directive still need to be checked (ignoring included file names)
+            const bool fileName = (directive == "include") && (nameStart < end) &&
+                ((code.at(nameStart) == '"') || (code.at(nameStart) == '<'));
+            for (uint i = dirEnd; (i < end) && !fileName;) {
+                if (nameChars.find(code.at(i)) != string::npos) {
+                    const uint identEnd = min<uint>(code.find_first_not_of(nameChars, i), end);
+                    if (!isdigit(code.at(i))) {
+                        symbols.identifiers.insert(code.substr(i, identEnd - i));
+                    }
+                    i = identEnd;
+                } else {
+                    ++i;
+                }
+            }
+            pos = end;
+            continue;
+        }
+        lineStart = false;
+        string token;
+        if (nameChars.find(c) != string::npos) {
+            uint end = code.find_first_not_of(nameChars, pos);
+            end = (end == string::npos) ? code.length() : end;
+            token = code.substr(pos, end - pos);
+            pos = end;
+            if (isdigit(token.at(0))) {
+                continue;
+            }
+            symbols.identifiers.insert(token);
+        } else {
+            token = c;
+            ++pos;
+        }
+
+        if (depth > 0) {
+            // Only file scope declarations are checked except for any enumerators
+            if (token == "{") {
+                ++depth;
+            } else if (token == "}") {
+                --depth;
+                enumBody = enumBody && (depth > 0);
+            } else if (enumBody && (depth == 1) && (nameChars.find(token.at(0)) != string::npos) &&
+                ((previous == "{") || (previous == ","))) {
+                symbols.declared.insert(token);
+            }
+            previous = token;
+            continue;
+        }
+        if (token == "{") {
+            ++depth;
+            // Find any struct, union or enum definition
+            uint tag = 0;
+            while ((tag < statement.size()) &&
+                ((statement[tag] == "typedef") || (statement[tag] == "static") || (statement[tag] == "const"))) {
+                ++tag;
+            }
+            if ((tag < statement.size()) &&
+                ((statement[tag] == "struct") || (statement[tag] == "union") || (statement[tag] == "enum"))) {
+                if ((tag + 1 < statement.size()) && (nameChars.find(statement[tag + 1].at(0)) != string::npos)) {
+                    symbols.declared.insert(statement[tag + 1]);
+                }
+                enumBody = statement[tag] == "enum";
+                previous = token;
+                statement.push_back(token);
+            } else if (find(statement.begin(), statement.end(), "=") != statement.end()) {
+                // Initialiser lists are skipped
+                statement.push_back(token);
+            } else {
+                // Function definition
+                findUnitySymbolsDeclarator(statement, symbols);
+                statement.clear();
+            }
+        } else if (token == ";") {
+            findUnitySymbolsDeclarator(statement, symbols);
+            statement.clear();
+        } else if (token == "}") {
+            // Unbalanced braces are ignored
+        } else {
+            statement.push_back(token);
+        }
+    }
+}
+
+void ProjectGenerator::findUnitySymbolsDeclarator(const StaticList& statement, UnitySymbols& symbols)
+{
+    // Only static and typedef declarations can conflict between files
+    if ((find(statement.begin(), statement.end(), "static") == statement.end()) &&
+        (find(statement.begin(), statement.end(), "typedef") == statement.end())) {
+        return;
+    }
+    const string nameChars = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_";
+    uint parens = 0;
+    if ((statement.size() > 1) && (statement[1] == "(") && (statement[0] != "static") &&
+        (statement[0] != "typedef")) {
+        // Macro wrapped declarations (such as DECLARE_ALIGNED) have the name as the last parameter
+        for (uint i = 1; i < statement.size(); i++) {
+            if (statement[i] == "(") {
+                ++parens;
+            } else if ((statement[i] == ")") && (--parens == 0)) {
+                if (nameChars.find(statement[i - 1].at(0)) != string::npos) {
+                    symbols.declared.insert(statement[i - 1]);
+                }
+                break;
+            }
+        }
+        return;
+    }
+    // Find the name of each declarator
+    string name;
+    bool found = false;
+    for (uint i = 0; i < statement.size(); i++) {
+        const string& token = statement[i];
+        if (token == "(") {
+            if ((parens == 0) && !found) {
+                // Function pointers have the name inside the first parenthesis
+                if ((i + 2 < statement.size()) && (statement[i + 1] == "*")) {
+                    name = statement[i + 2];
+                }
+                found = true;
+            }
+            ++parens;
+        } else if (token == ")") {
+            parens = (parens > 0) ? parens - 1 : 0;
+        } else if (parens == 0) {
+            if ((token == "[") || (token == "=") || (token == ":")) {
+                found = true;
+            } else if (token == ",") {
+                if (!name.empty()) {
+                    symbols.declared.insert(name);
+                }
+                name.clear();
+                found = false;
+            } else if (!found && (nameChars.find(token.at(0)) != string::npos)) {
+                name = token;
+            }
+        }
+    }
+    if (!name.empty()) {
+        symbols.declared.insert(name);
+    }
+}
+
+void ProjectGenerator::removeComments(const string& file, string& retCode)
+{
+    retCode.clear();
+    retCode.reserve(file.length());
+    for (uint i = 0; i < file.length(); i++) {
+        const char c = file.at(i);
+        const char next = (i + 1 < file.length()) ? file.at(i + 1) : '\0';
+        if ((c == '/') && (next == '/')) {
+            i = file.find('\n', i);
+            if (i == string::npos) {
+                break;
+            }
+            retCode += '\n';
+        } else if ((c == '/') && (next == '*')) {
+            const uint end = file.find("*/", i + 2);
+            if (end == string::npos) {
+                break;
+            }
+            // Keep any new lines so that pre-processor directives are still found
+            retCode.append(count(file.begin() + i, file.begin() + end, '\n'), '\n');
+            retCode += ' ';
+            i = end + 1;
+        } else if ((c == '"') || (c == '\'')) {
+            const uint start = i;
+            ++i;
+            while ((i < file.length()) && (file.at(i) != c) && (file.at(i) != '\n')) {
+                i += (file.at(i) == '\\') ? 2 : 1;
+            }
+            // Keep the file name of include directives as it is needed by callers
+            uint lineStart = retCode.rfind('\n');
+            lineStart = retCode.find_first_not_of(" \t", (lineStart == string::npos) ? 0 : lineStart + 1);
+            bool include = (lineStart != string::npos) && (retCode.at(lineStart) == '#');
+            if (include) {
+                lineStart = retCode.find_first_not_of(" \t", lineStart + 1);
+                include = (lineStart != string::npos) && (retCode.compare(lineStart, 7, "include") == 0);
+            }
+            if (include) {
+                retCode.append(file, start, min<uint>(i, file.length()) - start);
+            } else {
+                retCode += c;
+            }
+            retCode += c;
+        } else if ((c == '\\') && ((next == '\n') || (next == '\r'))) {
+            // Join any continued lines
+            i += ((next == '\r') && (i + 2 < file.length()) && (file.at(i + 2) == '\n')) ? 2 : 1;
+            retCode += ' ';
+        } else {
+            retCode += c;
+        }
+    }
+}
+
 bool ProjectGenerator::findProjectFiles(const StaticList& includes, StaticList& includesC, StaticList& includesCPP,
-    StaticList& includesASM, StaticList& includesH, StaticList& includesCU) const
+    StaticList& includesASM, StaticList& includesGAS, StaticList& includesH, StaticList& includesCU) const
 {
     for (const auto& include : includes) {
         string retFileName;
@@ -227,6 +1071,14 @@ bool ProjectGenerator::findProjectFiles(const StaticList& includes, StaticList&
                 continue;
             }
             includesASM.push_back(retFileName);
+        } else if (findSourceFile(include, ".S", retFileName)) {
+            // Found a GAS File to include
+            m_configHelper.makeFileProjectRelative(retFileName, retFileName);
+            if (find(includesGAS.begin(), includesGAS.end(), retFileName) != includesGAS.end()) {
+                // skip this item
+                continue;
+            }
+            includesGAS.push_back(retFileName);
         } else if (findSourceFile(include, ".h", retFileName)) {
             // Found a H File to include
             m_configHelper.makeFileProjectRelative(retFileName, retFileName);
@@ -0,0 +1,330 @@
+/*
+ * copyright (c) 2017 Matthew Oliver
+ *
+ * This file is part of ShiftMediaProject.
+ *
+ * ShiftMediaProject is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * ShiftMediaProject is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with ShiftMediaProject; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "projectGenerator.h"
+
+#include <algorithm>
+
+static string escapeNinjaPath(const string& path)
+{
+    // Spaces, colons and dollars have special meaning in build statements
+    string ret;
+    for (const auto& i : path) {
+        if ((i == ' ') || (i == ':') || (i == '$')) {
+            ret += '$';
+        }
+        ret += i;
+    }
+    return ret;
+}
+
+bool ProjectGenerator::outputNinjaProject(const StaticList& includeDirs, const StaticList& defines, const bool program)
+{
+    const string shortName = program ? m_projectName : m_projectName.substr(3);
+    const string objDir = "$objdir/" + m_projectName + '/';
+
+    // Get the include directories in the same order as the project templates
+    string rootDir;
+    m_configHelper.makeFileProjectRelative(m_configHelper.m_rootDirectory, rootDir);
+    rootDir = rootDir.empty() ? "." : rootDir;
+    StaticList includeDirs2 = {".", rootDir, "$(OutDir)/include", "$(ProjectDir)/../../prebuilt/include"};
+    includeDirs2.insert(includeDirs2.end(), includeDirs.begin(), includeDirs.end());
+    string includes;
+    for (auto& i : includeDirs2) {
+        buildNinjaPath(i);
+        includes += " -I\"" + i + '\"';
+    }
+    string includesASM = " -I\"./\" -I\"" + rootDir + "/\" -I\"" + rootDir + '/' + m_projectName + "/x86/\"";
+    findAndReplace(includesASM, "//", "/");
+
+    // Get the defines in the same order as the project templates
+    string defines2 = " -DWIN32 -D_WINDOWS -DHAVE_AV_CONFIG_H -D_USE_MATH_DEFINES -D_CRT_SECURE_NO_WARNINGS";
+    for (const auto& i : defines) {
+        defines2 += " -D" + i;
+    }
+    if (!program) {
+        defines2 += " -DBUILDING_" + shortName;
+    }
+
+    // Each project has its own set of variables that are used by all of its build statements
+    string build = "\n# " + m_projectName + '\n';
+    build += "includes_" + m_projectName + " =" + includes + '\n';
+    build += "defines_" + m_projectName + " =" + defines2 + '\n';
+    const string variables = "\n  includes = $includes_" + m_projectName + "\n  defines = $defines_" + m_projectName;
+    const string variablesStatic = variables + " -D_LIB\n";
+    const string variablesShared = variables + " -D_USRDLL -D_WINDLL\n";
+
+    // Add the source files in the same order as the project file so that objects are given the same names
+    StaticList foundObjects;
+    string objectName;
+    StaticList objects;
+    StaticList objectsStatic;
+    StaticList objectsShared;
+    string resourceFile;
+    if (findSourceFile(m_projectName.substr(3) + "res", ".rc", resourceFile)) {
+        m_configHelper.makeFileProjectRelative(resourceFile, resourceFile);
+        getSourceObjectName(resourceFile, false, foundObjects, objectName);
+        objectsShared.push_back(objDir + objectName + ".o");
+        build += "build " + objectsShared.back() + ": rc " + escapeNinjaPath(resourceFile) + variablesShared;
+    }
+    if (!m_includesASM.empty() && m_configHelper.isASMEnabled()) {
+        for (const auto& i : m_includesASM) {
+            // Assembly does not use any of the C defines so the same objects are used for static and shared
+            getSourceObjectName(i, false, foundObjects, objectName);
+            objects.push_back(objDir + objectName + ".o");
+            build += "build " + objects.back() + ": asm " + escapeNinjaPath(i) + "\n  asmincludes =" +
+                includesASM;
+            // Only files that use component options include the component config file
+            if (!m_configHelper.m_componentConfigs.empty()) {
+                StaticList includes;
+                if (!findASMIncludes(i, includes)) {
+                    return false;
+                }
+                includes.insert(includes.begin(), i);
+                bool components = false;
+                for (const auto& j : includes) {
+                    if (!findComponentUsage(j, components)) {
+                        return false;
+                    }
+                    if (components) {
+                        build += " -Pconfig_components.asm";
+                        break;
+                    }
+                }
+            }
+            build += '\n';
+        }
+    }
+    const StaticList* sourceFiles[] = {&m_includesC, &m_includesCPP};
+    const string rules[] = {"cc", "cxx"};
+    const string flags[] = {"cflags", "cxxflags"};
+    for (uint i = 0; i < 2; i++) {
+        for (const auto& j : *sourceFiles[i]) {
+            // The ninja build only targets x86 so any aarch64 sources are skipped
+            if (getSourceArch(j) == "aarch64") {
+                continue;
+            }
+            getSourceObjectName(j, true, foundObjects, objectName);
+            // The configuration header depends on the link type so shared objects must be built separately
+            objectsStatic.push_back(objDir + "static/" + objectName + ".o");
+            build += "build " + objectsStatic.back() + ": " + rules[i] + ' ' + escapeNinjaPath(j) + variablesStatic;
+            // Add any per file compiler flags
+            string fileFlags = getFileSettingsNinja(j);
+            bool components = false;
+            if (!m_configHelper.m_componentConfigs.empty() && !findComponentUsage(j, components)) {
+                return false;
+            }
+            if (components) {
+                // Only files that use component options include the component config file
+                fileFlags += fileFlags.empty() ? "-include config_components.h" : " -include config_components.h";
+            }
+            if (!fileFlags.empty()) {
+                fileFlags = "  " + flags[i] + " = $" + flags[i] + ' ' + fileFlags + '\n';
+                build += fileFlags;
+            }
+            if (!program) {
+                objectsShared.push_back(objDir + "shared/" + objectName + ".o");
+                build += "build " + objectsShared.back() + ": " + rules[i] + ' ' + escapeNinjaPath(j) +
+                    variablesShared + fileFlags;
+            }
+        }
+    }
+
+    // Get the library dependencies in link order
+    StaticList libs;
+    for (const auto& i : m_libs) {
+        libs.push_back((i.find("lib") != 0) ? "lib" + i : i);
+    }
+    buildInterDependencies(libs);
+    m_projectLibs[m_projectName] = libs;
+    StaticList addLibs;
+    buildDependencies(libs, addLibs);
+    StaticList& externLibs = m_ninjaBuild.libs[m_projectName];
+    externLibs.clear();
+    for (auto i = libs.begin() + m_projectLibs[m_projectName].size(); i < libs.end(); ++i) {
+        addLibs.push_back((i->find("lib") == 0) ? i->substr(3) : *i);
+    }
+    for (auto& i : addLibs) {
+        transform(i.begin(), i.end(), i.begin(), tolower);
+        if (find(externLibs.begin(), externLibs.end(), i) == externLibs.end()) {
+            externLibs.push_back(i);
+        }
+    }
+
+    // Add the link steps
+    string objectList;
+    for (const auto& i : objects) {
+        objectList += ' ' + i;
+    }
+    string staticList;
+    for (const auto& i : objectsStatic) {
+        staticList += ' ' + i;
+    }
+    if (program) {
+        // Programs are linked against the static libraries along with all of their external dependencies
+        StaticList programLibs = externLibs;
+        for (const auto& i : m_projectLibs[m_projectName]) {
+            staticList += " $libdir/" + i + ".a";
+            for (const auto& j : m_ninjaBuild.libs[i]) {
+                if (find(programLibs.begin(), programLibs.end(), j) == programLibs.end()) {
+                    programLibs.push_back(j);
+                }
+            }
+        }
+        string linkLibs;
+        for (const auto& i : programLibs) {
+            linkLibs += " -l" + i;
+        }
+        const string target = "$bindir/" + m_projectName + ".exe";
+        build += "build " + target + ": link" + objectList + staticList + "\n  libs =" + linkLibs + '\n';
+        m_ninjaBuild.staticTargets.push_back(target);
+    } else {
+        const string targetStatic = "$libdir/" + m_projectName + ".a";
+        build += "build " + targetStatic + ": ar" + objectList + staticList + '\n';
+        m_ninjaBuild.staticTargets.push_back(targetStatic);
+
+        // Shared libraries use the generated module definition file and link against the other import libraries
+        string sharedList;
+        for (const auto& i : objectsShared) {
+            sharedList += ' ' + i;
+        }
+        for (const auto& i : m_projectLibs[m_projectName]) {
+            sharedList += " $libdir/" + i + ".dll.a";
+        }
+        string linkLibs;
+        for (const auto& i : externLibs) {
+            linkLibs += " -l" + i;
+        }
+        const string targetShared = "$bindir/" + shortName + ".dll";
+        const string targetImport = "$libdir/" + m_projectName + ".dll.a";
+        build += "build " + targetShared + " | " + targetImport + ": link_shared" + objectList + sharedList + ' ' +
+            escapeNinjaPath(m_projectName + ".def") + "\n  implib = " + targetImport + "\n  libs =" + linkLibs + '\n';
+        m_ninjaBuild.sharedTargets.push_back(targetShared);
+    }
+    m_ninjaBuild.build += build;
+    return true;
+}
+
+bool ProjectGenerator::outputNinjaBuild()
+{
+    outputLine("  Generating ninja build file...");
+    string outDir = m_configHelper.m_outDirectory;
+    if (!outDir.empty() && (outDir.back() == '/')) {
+        outDir.pop_back();
+    }
+    const string assembler = m_configHelper.m_useNASM ? "nasm" : "yasm";
+
+    // The toolchain variables default to a mingw-w64 cross compiler
+    string ninja = "# Generated build file for gcc compatible compilers. The variables below can be changed to match\n\
+# the toolchain in use (e.g. cross_prefix = x86_64-w64-mingw32- or cc = clang --target=x86_64-w64-mingw32).\n\
+ninja_required_version = 1.3\n\
+\n\
+cross_prefix =\n\
+cc = ${cross_prefix}gcc\n\
+cxx = ${cross_prefix}g++\n\
+ar = ${cross_prefix}ar\n\
+windres = ${cross_prefix}windres\n\
+asm = " + assembler + "\n\
+asmformat = win64\n\
+asmflags =\n\
+cflags = -O2 -DNDEBUG\n\
+cxxflags = -O2 -DNDEBUG\n\
+ldflags =\n\
+outdir = " + escapeNinjaPath(outDir) + "\n\
+objdir = $outdir/obj\n\
+libdir = $outdir/lib\n\
+bindir = $outdir/bin\n\
+\n\
+rule cc\n\
+  command = $cc -MMD -MF $out.d $cflags $defines $includes -c $in -o $out\n\
+  depfile = $out.d\n\
+  deps = gcc\n\
+  description = CC $out\n\
+\n\
+rule cxx\n\
+  command = $cxx -MMD -MF $out.d $cxxflags $defines $includes -c $in -o $out\n\
+  depfile = $out.d\n\
+  deps = gcc\n\
+  description = CXX $out\n\
+\n";
+    if (m_configHelper.m_useNASM) {
+        ninja += "rule asm\n\
+  command = $asm -f $asmformat $asmflags $asmincludes -Pconfig.asm -MD $out.d -o $out $in\n\
+  depfile = $out.d\n\
+  deps = gcc\n\
+  description = ASM $out\n\
+\n";
+    } else {
+        // Yasm does not support outputting dependency information
+        ninja += "rule asm\n\
+  command = $asm -f $asmformat $asmflags $asmincludes -Pconfig.asm -o $out $in\n\
+  description = ASM $out\n\
+\n";
+    }
+    ninja += "rule rc\n\
+  command = $windres $defines $includes -i $in -o $out\n\
+  description = RC $out\n\
+\n\
+rule ar\n\
+  command = rm -f $out && $ar rcs $out $in\n\
+  description = AR $out\n\
+\n\
+rule link_shared\n\
+  command = $cc -shared $ldflags -o $out $in $libs -Wl,--out-implib,$implib\n\
+  description = LINK $out\n\
+\n\
+rule link\n\
+  command = $cc $ldflags -o $out $in $libs\n\
+  description = LINK $out\n";
+    ninja += m_ninjaBuild.build;
+
+    // Add targets to build all static or shared outputs
+    ninja += "\nbuild static: phony";
+    for (const auto& i : m_ninjaBuild.staticTargets) {
+        ninja += ' ' + i;
+    }
+    ninja += "\nbuild shared: phony";
+    for (const auto& i : m_ninjaBuild.sharedTargets) {
+        ninja += ' ' + i;
+    }
+    ninja += "\nbuild all: phony static shared\n\ndefault all\n";
+
+    return writeToFile(m_configHelper.m_solutionDirectory + "build.ninja", ninja);
+}
+
+void ProjectGenerator::buildNinjaPath(string& path)
+{
+    // Replace any project file macros with the equivalent ninja variable or environment variable
+    findAndReplace(path, "$(ProjectDir)", ".");
+    findAndReplace(path, "$(OutDir)", "$outdir");
+    uint findPos = path.find("$(");
+    while (findPos != string::npos) {
+        const uint findPos2 = path.find(')', findPos);
+        if (findPos2 == string::npos) {
+            break;
+        }
+        path.replace(findPos2, 1, "}");
+        path.replace(findPos, 2, "$${");
+        findPos = path.find("$(", findPos);
+    }
+    if (path.empty()) {
+        path = ".";
+    }
+}
@@ -282,6 +282,24 @@ bool ProjectGenerator::passDMMXInclude()
     return true;
 }
 
+bool ProjectGenerator::passARMInclude(const uint length)
+{
+    // Check if supported option
+    if (m_configHelper.m_useARM64) {
+        return passStaticInclude(length, m_includes);
+    }
+    return true;
+}
+
+bool ProjectGenerator::passDARMInclude(const uint length)
+{
+    // Check if supported option
+    if (m_configHelper.m_useARM64) {
+        return passDynamicInclude(length + 1, m_includes);
+    }
+    return true;
+}
+
 bool ProjectGenerator::passHInclude(const uint cutPos)
 {
     return passStaticInclude(cutPos, m_includesH);
@@ -420,6 +438,22 @@ bool ProjectGenerator::passMake()
                             return false;
                         }
                     }
+                } else if ((m_inLine.substr(0, 9) == "NEON-OBJS") || (m_inLine.substr(0, 10) == "ARMV8-OBJS")) {
+                    // Found some aarch64 includes
+                    const uint length = (m_inLine.at(0) == 'N') ? 9 : 10;
+                    if (m_inLine.at(length) == '-') {
+                        // Found some dynamic aarch64 includes
+                        if (!passDARMInclude(length)) {
+                            m_inputFile.close();
+                            return false;
+                        }
+                    } else {
+                        // Found some static aarch64 includes
+                        if (!passARMInclude(length)) {
+                            m_inputFile.close();
+                            return false;
+                        }
+                    }
                 } else if (m_inLine.substr(0, 7) == "HEADERS") {
                     // Found some headers
                     if (m_inLine.at(7) == '-') {
@@ -30,10 +30,6 @@ int main(const int argc, char** argv)
         projectGenerator.errorFunc(false);
     }
 
-    // Delete any previously generated files
-    projectGenerator.m_configHelper.deleteCreatedFiles();
-    projectGenerator.deleteCreatedFiles();
-
     // Output config.h and avutil.h
     if (!projectGenerator.m_configHelper.outputConfig()) {
         projectGenerator.errorFunc();
@@ -43,6 +39,10 @@ int main(const int argc, char** argv)
     if (!projectGenerator.passAllMake()) {
         projectGenerator.errorFunc();
     }
+
+    // Delete any previously generated files that were not output again (unchanged files are left untouched)
+    projectGenerator.m_configHelper.deleteCreatedFiles(true);
+    projectGenerator.deleteCreatedFiles(true);
     outputLine("Completed Successfully");
 #if _DEBUG
     pressKeyToContinue();
@@ -26,7 +26,7 @@
 #define SMP_COMPAT_H
 
 #ifdef _MSC_VER
-#   ifndef __cplusplus
+#   if !defined(__cplusplus) && !defined(__clang__)
 #       define inline __inline
 #   endif
 #   include <crtversion.h>
@@ -0,0 +1,40 @@
+@ECHO OFF
+
+SET PROJECT=template_in
+SET PROGRAM=template_program
+SET OUTDIR=template_outdir
+
+@REM This must be run from a Visual Studio developer command prompt so that msbuild and the
+@REM profile guided optimisation runtime are available. The platform can be changed by setting
+@REM PGO_PLATFORM to Win32 and any passed parameters replace the default training workload.
+SETLOCAL
+IF "%PGO_PLATFORM%"=="" SET PGO_PLATFORM=x64
+SET ARCH=x64
+IF "%PGO_PLATFORM%"=="Win32" SET ARCH=x86
+SET BINDIR=%OUTDIR%\bin\%ARCH%\pgo
+SET TRAINFILE=%TEMP%\%PROJECT%_pgo_training.mkv
+
+@REM Build the instrumented configuration
+msbuild "%~dp0%PROJECT%.sln" /m /p:Configuration=ReleasePGInstrument /p:Platform=%PGO_PLATFORM%
+IF ERRORLEVEL 1 EXIT /B 1
+
+@REM Remove any previous training data
+DEL /Q "%OUTDIR%\pgo\%PGO_PLATFORM%\*.pgc" > nul 2>&1
+
+@REM Run the training workload
+IF NOT "%~1"=="" (
+    "%BINDIR%\%PROGRAM%.exe" %*
+    IF ERRORLEVEL 1 EXIT /B 1
+    GOTO Optimize
+)
+"%BINDIR%\%PROGRAM%.exe" -y -f lavfi -i testsrc2=duration=20:size=1280x720:rate=30 -f lavfi -i sine=duration=20 -c:v mpeg4 -q:v 4 -c:a aac "%TRAINFILE%"
+IF ERRORLEVEL 1 EXIT /B 1
+"%BINDIR%\%PROGRAM%.exe" -i "%TRAINFILE%" -vf scale=640:360 -c:v mpeg4 -c:a aac -f null -
+IF ERRORLEVEL 1 EXIT /B 1
+DEL /Q "%TRAINFILE%" > nul 2>&1
+
+:Optimize
+@REM Build the optimised configuration using the collected training data
+msbuild "%~dp0%PROJECT%.sln" /m /p:Configuration=ReleasePGOptimize /p:Platform=%PGO_PLATFORM%
+IF ERRORLEVEL 1 EXIT /B 1
+EXIT /B 0